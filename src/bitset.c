@@ -0,0 +1,182 @@
+/* bitset.c - PacFinder fixed size bit sets for package index sets
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "bitset.h"
+
+/* system libraries */
+#include <glib.h>
+#include <string.h>
+
+#define WORD_BITS 64
+#define WORD_INDEX(bit) ((bit) / WORD_BITS)
+#define WORD_MASK(bit) ((guint64)1 << ((bit) % WORD_BITS))
+
+/* clear the unused high bits of the last word so counts stay exact */
+static void trim_last_word(bitset_t *set)
+{
+	guint used = set->size % WORD_BITS;
+
+	if (used != 0) {
+		set->words[set->n_words - 1] &= ((guint64)1 << used) - 1;
+	}
+}
+
+bitset_t *bitset_new(const guint size)
+{
+	guint n_words = (size + WORD_BITS - 1) / WORD_BITS;
+	bitset_t *set;
+
+	set = g_malloc0(sizeof(bitset_t) + n_words * sizeof(guint64));
+	set->size = size;
+	set->n_words = n_words;
+
+	return set;
+}
+
+bitset_t *bitset_copy(const bitset_t *set)
+{
+	gsize bytes = sizeof(bitset_t) + set->n_words * sizeof(guint64);
+	bitset_t *copy = g_malloc(bytes);
+
+	memcpy(copy, set, bytes);
+
+	return copy;
+}
+
+void bitset_free(bitset_t *set)
+{
+	g_free(set);
+}
+
+void bitset_set(bitset_t *set, const guint bit)
+{
+	g_return_if_fail(bit < set->size);
+
+	set->words[WORD_INDEX(bit)] |= WORD_MASK(bit);
+}
+
+void bitset_unset(bitset_t *set, const guint bit)
+{
+	g_return_if_fail(bit < set->size);
+
+	set->words[WORD_INDEX(bit)] &= ~WORD_MASK(bit);
+}
+
+gboolean bitset_get(const bitset_t *set, const guint bit)
+{
+	g_return_val_if_fail(bit < set->size, FALSE);
+
+	return (set->words[WORD_INDEX(bit)] & WORD_MASK(bit)) != 0;
+}
+
+void bitset_zero(bitset_t *set)
+{
+	memset(set->words, 0, set->n_words * sizeof(guint64));
+}
+
+void bitset_fill(bitset_t *set)
+{
+	memset(set->words, 0xff, set->n_words * sizeof(guint64));
+	trim_last_word(set);
+}
+
+void bitset_union(bitset_t *dest, const bitset_t *src)
+{
+	guint i;
+
+	g_return_if_fail(dest->size == src->size);
+
+	for (i = 0; i < dest->n_words; i++) {
+		dest->words[i] |= src->words[i];
+	}
+}
+
+void bitset_intersect(bitset_t *dest, const bitset_t *src)
+{
+	guint i;
+
+	g_return_if_fail(dest->size == src->size);
+
+	for (i = 0; i < dest->n_words; i++) {
+		dest->words[i] &= src->words[i];
+	}
+}
+
+void bitset_subtract(bitset_t *dest, const bitset_t *src)
+{
+	guint i;
+
+	g_return_if_fail(dest->size == src->size);
+
+	for (i = 0; i < dest->n_words; i++) {
+		dest->words[i] &= ~src->words[i];
+	}
+}
+
+guint bitset_count(const bitset_t *set)
+{
+	guint i, count = 0;
+
+	for (i = 0; i < set->n_words; i++) {
+		count += __builtin_popcountll(set->words[i]);
+	}
+
+	return count;
+}
+
+guint bitset_count_intersection(const bitset_t *set1, const bitset_t *set2)
+{
+	guint i, count = 0;
+
+	g_return_val_if_fail(set1->size == set2->size, 0);
+
+	for (i = 0; i < set1->n_words; i++) {
+		count += __builtin_popcountll(set1->words[i] & set2->words[i]);
+	}
+
+	return count;
+}
+
+/* finds the first set bit at or after *bit, returns FALSE when there are none left */
+gboolean bitset_next(const bitset_t *set, guint *bit)
+{
+	guint word_index;
+	guint64 word;
+
+	if (*bit >= set->size) {
+		return FALSE;
+	}
+
+	word_index = WORD_INDEX(*bit);
+	word = set->words[word_index] & ~(WORD_MASK(*bit) - 1);
+
+	while (word == 0) {
+		word_index++;
+		if (word_index >= set->n_words) {
+			return FALSE;
+		}
+		word = set->words[word_index];
+	}
+
+	*bit = word_index * WORD_BITS + __builtin_ctzll(word);
+
+	return TRUE;
+}
@@ -0,0 +1,44 @@
+/* bitset.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_BITSET_H
+#define PF_BITSET_H
+
+#include <glib.h>
+
+typedef struct {
+	guint size;
+	guint n_words;
+	guint64 words[];
+} bitset_t;
+
+bitset_t *bitset_new(const guint size);
+bitset_t *bitset_copy(const bitset_t *set);
+void bitset_free(bitset_t *set);
+void bitset_set(bitset_t *set, const guint bit);
+void bitset_unset(bitset_t *set, const guint bit);
+gboolean bitset_get(const bitset_t *set, const guint bit);
+void bitset_zero(bitset_t *set);
+void bitset_fill(bitset_t *set);
+void bitset_union(bitset_t *dest, const bitset_t *src);
+void bitset_intersect(bitset_t *dest, const bitset_t *src);
+void bitset_subtract(bitset_t *dest, const bitset_t *src);
+guint bitset_count(const bitset_t *set);
+guint bitset_count_intersection(const bitset_t *set1, const bitset_t *set2);
+gboolean bitset_next(const bitset_t *set, guint *bit);
+
+#endif /* PF_BITSET_H */
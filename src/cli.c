@@ -0,0 +1,162 @@
+/* cli.c - PacFinder command line queries
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "cli.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "depgraph.h"
+#include "exportformat.h"
+#include "pkgtable.h"
+#include "query.h"
+
+/* rows evaluated and printed at a time, so output starts before the whole package
+ * list has been searched */
+#define CLI_CHUNK_ROWS 4096
+
+typedef enum {
+	CLI_FORMAT_TEXT = 0,
+	CLI_FORMAT_JSON
+} cli_format_t;
+
+static void append_text_row(GString *out, const struct pkg_table_t *table, const guint row)
+{
+	alpm_pkg_t *pkg = table->pkgs[row];
+
+	g_string_append_printf(
+		out,
+		"%s/%s %s",
+		alpm_db_get_name(alpm_pkg_get_db(pkg)),
+		alpm_pkg_get_name(pkg),
+		alpm_pkg_get_version(pkg)
+	);
+	if (table->statuses[row] != PKG_REASON_NOT_INSTALLED) {
+		g_string_append_printf(out, " [%s]", get_status_name(table->statuses[row]));
+	}
+	g_string_append_c(out, '\n');
+}
+
+static gboolean parse_format(const gchar *name, cli_format_t *format)
+{
+	if (name == NULL || g_strcmp0(name, "text") == 0) {
+		*format = CLI_FORMAT_TEXT;
+	} else if (g_strcmp0(name, "json") == 0) {
+		*format = CLI_FORMAT_JSON;
+	} else {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* prints the packages matching a search query, without gtk. the query runs over
+ * one chunk of the package table at a time and each chunk is written out as soon
+ * as it is done */
+gint run_cli_query(const gchar *query_str, const gchar *format_name)
+{
+	struct pkg_table_t *table;
+	struct query_t *query;
+	GError *error = NULL;
+	cli_format_t format;
+	struct dep_graph_t *local_graph;
+	struct export_row_t json_row;
+	bitset_t *chunk;
+	GString *out;
+	gint64 start_time;
+	guint start, row, matches = 0;
+
+	if (!parse_format(format_name, &format)) {
+		/* l10n: cli error - %s is what was given to --format */
+		g_printerr(_("Unknown output format \"%s\", expected text or json"), format_name);
+		g_printerr("\n");
+		return EXIT_FAILURE;
+	}
+
+	query = query_parse(query_str, &error);
+	if (query == NULL) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return EXIT_FAILURE;
+	}
+
+	start_time = g_get_monotonic_time();
+	table = get_pkg_table();
+	g_debug("loaded %u packages in %" G_GINT64_FORMAT " us", table->n_rows, g_get_monotonic_time() - start_time);
+
+	start_time = g_get_monotonic_time();
+	local_graph = get_local_dep_graph();
+	chunk = bitset_new(table->n_rows);
+	out = g_string_new(NULL);
+	if (format == CLI_FORMAT_JSON) {
+		export_append_header(out, EXPORT_FORMAT_JSON);
+	}
+
+	for (start = 0; start < table->n_rows; start += CLI_CHUNK_ROWS) {
+		guint end = MIN(start + CLI_CHUNK_ROWS, table->n_rows);
+
+		bitset_zero(chunk);
+		for (row = start; row < end; row++) {
+			bitset_set(chunk, row);
+		}
+		pkg_table_narrow_rows(table, query, chunk);
+
+		for (row = start; bitset_next(chunk, &row); row++) {
+			if (format == CLI_FORMAT_JSON) {
+				/* the same rows as a json export */
+				export_read_row(table, local_graph, row, &json_row);
+				export_append_row(out, EXPORT_FORMAT_JSON, &json_row, matches);
+			} else {
+				append_text_row(out, table, row);
+			}
+			matches++;
+		}
+
+		fwrite(out->str, 1, out->len, stdout);
+		fflush(stdout);
+		g_string_truncate(out, 0);
+	}
+
+	/* whatever is left, the opening bracket too when there were no packages */
+	if (format == CLI_FORMAT_JSON) {
+		export_append_footer(out, EXPORT_FORMAT_JSON, matches);
+	}
+	fwrite(out->str, 1, out->len, stdout);
+
+	g_debug("matched %u of %u packages in %" G_GINT64_FORMAT " us",
+		matches, table->n_rows, g_get_monotonic_time() - start_time);
+
+	g_string_free(out, TRUE);
+	bitset_free(chunk);
+	query_free(query);
+	pkg_table_free();
+	dep_graph_free();
+	database_free();
+
+	return EXIT_SUCCESS;
+}
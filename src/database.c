@@ -42,6 +42,19 @@ static alpm_handle_t *handle = NULL;
 static alpm_db_t *db_local = NULL;
 static alpm_list_t *all_packages_list = NULL;
 
+/* lookup indexes built alongside the all packages list. keys point to strings
+ * owned by libalpm, so they are only valid until the handle is released */
+static GHashTable *package_index = NULL;
+static GHashTable *all_provisions = NULL;
+static GHashTable *local_provisions = NULL;
+static GHashTable *conflicted_by_index = NULL;
+static GHashTable *replaced_by_index = NULL;
+/* name to the sync packages of that name, highest priority repository first */
+static GHashTable *repo_versions = NULL;
+/* pkgbase to the packages built from it, and every pkgbase in name order */
+static GHashTable *pkgbase_index = NULL;
+static GPtrArray *pkgbase_names = NULL;
+
 static gboolean register_syncs(const gchar *file_path, const gint depth)
 {
 	static GList *processed_files = NULL;
@@ -156,6 +169,193 @@ static void initialize_alpm(void)
 	}
 }
 
+/* maps each package name and provided name to the packages carrying it, in
+ * list order, so satisfier lookups pick the same package alpm would */
+static GHashTable *build_provision_index(alpm_list_t *pkgs)
+{
+	GHashTable *index;
+	alpm_list_t *i, *provides;
+
+	index = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+
+	for (i = pkgs; i; i = alpm_list_next(i)) {
+		alpm_pkg_t *pkg = i->data;
+		const gchar *name = alpm_pkg_get_name(pkg);
+		GPtrArray *candidates;
+
+		candidates = g_hash_table_lookup(index, name);
+		if (candidates == NULL) {
+			candidates = g_ptr_array_new();
+			g_hash_table_insert(index, (gpointer)name, candidates);
+		}
+		g_ptr_array_add(candidates, pkg);
+
+		for (provides = alpm_pkg_get_provides(pkg); provides; provides = alpm_list_next(provides)) {
+			const alpm_depend_t *prov = provides->data;
+
+			candidates = g_hash_table_lookup(index, prov->name);
+			if (candidates == NULL) {
+				candidates = g_ptr_array_new();
+				g_hash_table_insert(index, prov->name, candidates);
+			}
+			/* skip packages that provide their own name or list a provision twice */
+			if (candidates->len == 0 || g_ptr_array_index(candidates, candidates->len - 1) != pkg) {
+				g_ptr_array_add(candidates, pkg);
+			}
+		}
+	}
+
+	return index;
+}
+
+/* maps each package to the packages whose list, from the given getter, names
+ * it. entries are matched by name or provision, like dependencies are */
+static GHashTable *build_reverse_index(alpm_list_t *(*get_deps)(alpm_pkg_t *pkg))
+{
+	GHashTable *index;
+	alpm_list_t *i, *deps;
+
+	index = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+
+	for (i = all_packages_list; i; i = alpm_list_next(i)) {
+		alpm_pkg_t *pkg = i->data;
+
+		for (deps = get_deps(pkg); deps; deps = alpm_list_next(deps)) {
+			const alpm_depend_t *dep = deps->data;
+			GPtrArray *candidates;
+			guint x;
+
+			candidates = g_hash_table_lookup(all_provisions, dep->name);
+			if (candidates == NULL) {
+				continue;
+			}
+
+			for (x = 0; x < candidates->len; x++) {
+				alpm_pkg_t *target = g_ptr_array_index(candidates, x);
+				GPtrArray *sources;
+
+				/* packages commonly conflict with a name they provide themselves */
+				if (target == pkg || !pkg_satisfies_dep(target, dep)) {
+					continue;
+				}
+
+				sources = g_hash_table_lookup(index, target);
+				if (sources == NULL) {
+					sources = g_ptr_array_new();
+					g_hash_table_insert(index, target, sources);
+				}
+				/* one package may list several entries matching the same target */
+				if (sources->len == 0 || g_ptr_array_index(sources, sources->len - 1) != pkg) {
+					g_ptr_array_add(sources, pkg);
+				}
+			}
+		}
+	}
+
+	return index;
+}
+
+static gint compare_names(gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0(*(const gchar **)a, *(const gchar **)b);
+}
+
+static void build_pkgbase_index(void)
+{
+	alpm_list_t *i;
+
+	pkgbase_index = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+	pkgbase_names = g_ptr_array_new();
+
+	for (i = all_packages_list; i; i = alpm_list_next(i)) {
+		alpm_pkg_t *pkg = i->data;
+		const gchar *base = get_pkg_base(pkg);
+		GPtrArray *members;
+
+		members = g_hash_table_lookup(pkgbase_index, base);
+		if (members == NULL) {
+			members = g_ptr_array_sized_new(1);
+			g_hash_table_insert(pkgbase_index, (gpointer)base, members);
+			g_ptr_array_add(pkgbase_names, (gpointer)base);
+		}
+		g_ptr_array_add(members, pkg);
+	}
+
+	g_ptr_array_sort(pkgbase_names, compare_names);
+}
+
+static void build_indexes(void)
+{
+	alpm_list_t *i;
+
+	package_index = g_hash_table_new(g_str_hash, g_str_equal);
+	for (i = all_packages_list; i; i = alpm_list_next(i)) {
+		alpm_pkg_t *pkg = i->data;
+		const gchar *name = alpm_pkg_get_name(pkg);
+
+		/* keep the first package of a given name, same as alpm_pkg_find */
+		if (!g_hash_table_contains(package_index, name)) {
+			g_hash_table_insert(package_index, (gpointer)name, pkg);
+		}
+	}
+
+	all_provisions = build_provision_index(all_packages_list);
+	local_provisions = build_provision_index(alpm_db_get_pkgcache(get_local_db()));
+	conflicted_by_index = build_reverse_index(alpm_pkg_get_conflicts);
+	replaced_by_index = build_reverse_index(alpm_pkg_get_replaces);
+	build_pkgbase_index();
+}
+
+static gboolean version_satisfies(const gchar *version, const alpm_depmod_t mod, const gchar *required)
+{
+	gint cmp;
+
+	if (mod == ALPM_DEP_MOD_ANY) {
+		return TRUE;
+	}
+
+	cmp = alpm_pkg_vercmp(version, required);
+
+	switch (mod) {
+		case ALPM_DEP_MOD_EQ:
+			return cmp == 0;
+		case ALPM_DEP_MOD_GE:
+			return cmp >= 0;
+		case ALPM_DEP_MOD_LE:
+			return cmp <= 0;
+		case ALPM_DEP_MOD_GT:
+			return cmp > 0;
+		case ALPM_DEP_MOD_LT:
+			return cmp < 0;
+		default:
+			return TRUE;
+	}
+}
+
+static alpm_pkg_t *find_indexed_satisfier(GHashTable *index, const alpm_depend_t *dep)
+{
+	GPtrArray *candidates;
+	guint i;
+
+	if (index == NULL) {
+		return NULL;
+	}
+
+	candidates = g_hash_table_lookup(index, dep->name);
+	if (candidates == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < candidates->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(candidates, i);
+		if (pkg_satisfies_dep(pkg, dep)) {
+			return pkg;
+		}
+	}
+
+	return NULL;
+}
+
 alpm_handle_t *get_alpm_handle(void)
 {
 	if (handle == NULL) {
@@ -177,10 +377,13 @@ alpm_list_t *get_all_packages(void)
 	alpm_list_t *i;
 
 	if (all_packages_list == NULL) {
-		/* collect all packages from the syncdbs */
+		repo_versions = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify)g_ptr_array_unref);
+
+		/* collect all packages from the syncdbs, which are listed in priority order */
 		for (i = alpm_get_syncdbs(get_alpm_handle()); i; i = i->next) {
 			alpm_db_t *db = i->data;
 			alpm_list_t *db_package_list = alpm_db_get_pkgcache(db);
+			alpm_list_t *j;
 
 			if (db_package_list != NULL) {
 				all_packages_list = alpm_list_join(
@@ -188,6 +391,17 @@ alpm_list_t *get_all_packages(void)
 					alpm_list_copy(db_package_list)
 				);
 			}
+
+			for (j = db_package_list; j; j = alpm_list_next(j)) {
+				const gchar *name = alpm_pkg_get_name(j->data);
+				GPtrArray *versions = g_hash_table_lookup(repo_versions, name);
+
+				if (versions == NULL) {
+					versions = g_ptr_array_sized_new(1);
+					g_hash_table_insert(repo_versions, (gpointer)name, versions);
+				}
+				g_ptr_array_add(versions, j->data);
+			}
 		}
 
 		/* iterate the localdb packages and find any that are not listed in the
@@ -196,18 +410,21 @@ alpm_list_t *get_all_packages(void)
 		for (i = alpm_db_get_pkgcache(get_local_db()); i; i = i->next) {
 			alpm_pkg_t *pkg = i->data;
 
-			if (!alpm_list_find(all_packages_list, pkg, package_cmp)) {
+			if (!g_hash_table_contains(repo_versions, alpm_pkg_get_name(pkg))) {
 				foreign_pkg_list = alpm_list_add(foreign_pkg_list, pkg);
 				all_packages_list = alpm_list_add(all_packages_list, pkg);
 			}
 		}
 
-		/* sort the final list */
+		/* sort the final list, the sort is stable so duplicate names stay in
+		 * repository priority order */
 		all_packages_list = alpm_list_msort(
 			all_packages_list,
 			alpm_list_count(all_packages_list),
 			package_cmp
 		);
+
+		build_indexes();
 	}
 
 	return all_packages_list;
@@ -215,27 +432,179 @@ alpm_list_t *get_all_packages(void)
 
 alpm_pkg_t *find_package(const gchar *pkg_name)
 {
-	return alpm_pkg_find(all_packages_list, pkg_name);
+	if (package_index == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(package_index, pkg_name);
 }
 
-alpm_pkg_t *find_satisfier(const gchar *dep_str)
+/* same as pkg_satisfies_dep() on package fields read up front. it doesn't call
+ * into the libalpm handle, so it is safe to use from other threads */
+gboolean dep_satisfied_by(const gchar *name, const gchar *version, alpm_list_t *provides, const alpm_depend_t *dep)
+{
+	/* literal name match */
+	if (g_strcmp0(name, dep->name) == 0 && version_satisfies(version, dep->mod, dep->version)) {
+		return TRUE;
+	}
+
+	/* provisions only satisfy versioned dependencies when they carry an exact version */
+	for (; provides; provides = provides->next) {
+		const alpm_depend_t *prov = provides->data;
+
+		if (g_strcmp0(prov->name, dep->name) != 0) {
+			continue;
+		}
+		if (dep->mod == ALPM_DEP_MOD_ANY) {
+			return TRUE;
+		}
+		if (prov->mod == ALPM_DEP_MOD_EQ && version_satisfies(prov->version, dep->mod, dep->version)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+gboolean pkg_satisfies_dep(alpm_pkg_t *pkg, const alpm_depend_t *dep)
+{
+	return dep_satisfied_by(
+		alpm_pkg_get_name(pkg),
+		alpm_pkg_get_version(pkg),
+		alpm_pkg_get_provides(pkg),
+		dep
+	);
+}
+
+alpm_pkg_t *find_dep_satisfier(const alpm_depend_t *dep)
 {
 	alpm_pkg_t *ret;
 
 	/* prefer installed packages */
-	ret = alpm_find_satisfier(alpm_db_get_pkgcache(get_local_db()), dep_str);
+	ret = find_indexed_satisfier(local_provisions, dep);
 
 	if (ret) {
 		/* return sync db version of the package, for full dependency relations list */
 		ret = find_package(alpm_pkg_get_name(ret));
 	} else {
 		/* if no installed packages satisfy, then search all known packages */
-		ret = alpm_find_satisfier(all_packages_list, dep_str);
+		ret = find_indexed_satisfier(all_provisions, dep);
+	}
+
+	return ret;
+}
+
+/* every package providing a name, from the sync dbs and the installed packages.
+ * installed packages are returned as their sync db version when there is one,
+ * so the list never repeats a package name */
+GPtrArray *find_providers(const gchar *name)
+{
+	GPtrArray *ret, *candidates;
+	GHashTable *seen;
+	guint i;
+
+	ret = g_ptr_array_new();
+	seen = g_hash_table_new(g_str_hash, g_str_equal);
+
+	candidates = all_provisions ? g_hash_table_lookup(all_provisions, name) : NULL;
+	for (i = 0; candidates != NULL && i < candidates->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(candidates, i);
+
+		if (g_hash_table_add(seen, (gpointer)alpm_pkg_get_name(pkg))) {
+			g_ptr_array_add(ret, pkg);
+		}
+	}
+
+	/* an installed version may provide names its sync db version no longer does */
+	candidates = local_provisions ? g_hash_table_lookup(local_provisions, name) : NULL;
+	for (i = 0; candidates != NULL && i < candidates->len; i++) {
+		alpm_pkg_t *local_pkg = g_ptr_array_index(candidates, i);
+		alpm_pkg_t *pkg = find_package(alpm_pkg_get_name(local_pkg));
+
+		if (pkg != NULL && g_hash_table_add(seen, (gpointer)alpm_pkg_get_name(pkg))) {
+			g_ptr_array_add(ret, pkg);
+		}
 	}
 
+	g_hash_table_destroy(seen);
+
 	return ret;
 }
 
+alpm_pkg_t *find_satisfier(const gchar *dep_str)
+{
+	alpm_depend_t *dep;
+	alpm_pkg_t *ret;
+
+	dep = alpm_dep_from_string(dep_str);
+	if (dep == NULL) {
+		return NULL;
+	}
+
+	ret = find_dep_satisfier(dep);
+	alpm_dep_free(dep);
+
+	return ret;
+}
+
+/* sync packages named the same in every repository, highest priority first. NULL
+ * for names only known to the local database */
+GPtrArray *get_repo_versions(const gchar *name)
+{
+	if (repo_versions == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(repo_versions, name);
+}
+
+/* whether a higher priority repository has a package of the same name, in which
+ * case pacman never installs this one */
+gboolean is_pkg_shadowed(alpm_pkg_t *pkg)
+{
+	GPtrArray *versions = get_repo_versions(alpm_pkg_get_name(pkg));
+
+	return versions != NULL && versions->len > 1 && g_ptr_array_index(versions, 0) != pkg;
+}
+
+/* packages built by older tools may not record a pkgbase, their name stands in */
+const gchar *get_pkg_base(alpm_pkg_t *pkg)
+{
+	const gchar *base = alpm_pkg_get_base(pkg);
+
+	return base != NULL ? base : alpm_pkg_get_name(pkg);
+}
+
+/* every pkgbase in name order */
+GPtrArray *get_pkgbases(void)
+{
+	return pkgbase_names;
+}
+
+/* packages built from a pkgbase in name order, duplicates from several
+ * repositories included */
+GPtrArray *get_pkgbase_members(const gchar *base)
+{
+	if (pkgbase_index == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(pkgbase_index, base);
+}
+
+GPtrArray *get_pkg_conflicted_by(alpm_pkg_t *pkg)
+{
+	if (conflicted_by_index == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(conflicted_by_index, pkg);
+}
+
+GPtrArray *get_pkg_replaced_by(alpm_pkg_t *pkg)
+{
+	if (replaced_by_index == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(replaced_by_index, pkg);
+}
+
 alpm_depend_t *find_pkg_optdep(alpm_pkg_t *pkg, alpm_pkg_t *optpkg)
 {
 	const gchar *pkgname = alpm_pkg_get_name(pkg);
@@ -271,17 +640,75 @@ alpm_depend_t *find_pkg_optdep(alpm_pkg_t *pkg, alpm_pkg_t *optpkg)
 	return ret;
 }
 
-install_reason_t get_pkg_status(alpm_pkg_t *pkg)
+/* installed packages named or providing a name, without checking versions. the
+ * index isn't modified after load, so this is safe to use from other threads */
+GPtrArray *find_local_candidates(const gchar *name)
+{
+	if (local_provisions == NULL) {
+		return NULL;
+	}
+	return g_hash_table_lookup(local_provisions, name);
+}
+
+alpm_list_t *find_local_satisfiers(const alpm_depend_t *dep)
+{
+	alpm_list_t *ret = NULL;
+	GPtrArray *candidates;
+	guint i;
+
+	if (local_provisions == NULL) {
+		return NULL;
+	}
+
+	candidates = g_hash_table_lookup(local_provisions, dep->name);
+	if (candidates == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < candidates->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(candidates, i);
+		if (pkg_satisfies_dep(pkg, dep)) {
+			ret = alpm_list_add(ret, pkg);
+		}
+	}
+
+	return ret;
+}
+
+install_reason_t get_status_from_relations(const alpm_pkgreason_t reason, const gboolean required, const gboolean optional)
 {
 	static const install_reason_t reason_map[] = {
 		[ALPM_PKG_REASON_EXPLICIT] = PKG_REASON_EXPLICIT,
 		[ALPM_PKG_REASON_DEPEND] = PKG_REASON_DEPEND
 	};
 
+	if (reason == ALPM_PKG_REASON_DEPEND && !required) {
+		return optional ? PKG_REASON_OPTIONAL : PKG_REASON_ORPHAN;
+	}
+
+	return reason_map[reason];
+}
+
+/* the same words the query language uses for statuses, for machine readable output */
+const gchar *get_status_name(const install_reason_t status)
+{
+	static const gchar *status_names[] = {
+		[PKG_REASON_NOT_INSTALLED] = "uninstalled",
+		[PKG_REASON_EXPLICIT] = "explicit",
+		[PKG_REASON_DEPEND] = "depend",
+		[PKG_REASON_OPTIONAL] = "optional",
+		[PKG_REASON_ORPHAN] = "orphan"
+	};
+
+	return status_names[status];
+}
+
+install_reason_t get_pkg_status(alpm_pkg_t *pkg)
+{
 	install_reason_t ret;
 	alpm_pkg_t *local_pkg;
 	alpm_pkgreason_t install_reason;
-	alpm_list_t *required_by, *optional_for;
+	alpm_list_t *required_by, *optional_for = NULL;
 
 	ret = PKG_REASON_NOT_INSTALLED;
 
@@ -291,21 +718,15 @@ install_reason_t get_pkg_status(alpm_pkg_t *pkg)
 		install_reason = alpm_pkg_get_reason(local_pkg);
 		required_by = alpm_pkg_compute_requiredby(local_pkg);
 
-		if (install_reason == ALPM_PKG_REASON_DEPEND && alpm_list_count(required_by) == 0) {
+		/* optional dependents only matter for dependencies nothing requires */
+		if (install_reason == ALPM_PKG_REASON_DEPEND && required_by == NULL) {
 			optional_for = alpm_pkg_compute_optionalfor(local_pkg);
-
-			if (alpm_list_count(optional_for) == 0) {
-				ret = PKG_REASON_ORPHAN;
-			} else {
-				ret = PKG_REASON_OPTIONAL;
-			}
-
-			alpm_list_free_inner(optional_for, g_free);
-			alpm_list_free(optional_for);
-		} else {
-			ret = reason_map[install_reason];
 		}
 
+		ret = get_status_from_relations(install_reason, required_by != NULL, optional_for != NULL);
+
+		alpm_list_free_inner(optional_for, g_free);
+		alpm_list_free(optional_for);
 		alpm_list_free_inner(required_by, g_free);
 		alpm_list_free(required_by);
 	}
@@ -316,6 +737,14 @@ install_reason_t get_pkg_status(alpm_pkg_t *pkg)
 void database_free(void)
 {
 	if (handle) {
+		g_clear_pointer(&package_index, g_hash_table_destroy);
+		g_clear_pointer(&all_provisions, g_hash_table_destroy);
+		g_clear_pointer(&local_provisions, g_hash_table_destroy);
+		g_clear_pointer(&conflicted_by_index, g_hash_table_destroy);
+		g_clear_pointer(&replaced_by_index, g_hash_table_destroy);
+		g_clear_pointer(&repo_versions, g_hash_table_destroy);
+		g_clear_pointer(&pkgbase_index, g_hash_table_destroy);
+		g_clear_pointer(&pkgbase_names, g_ptr_array_unref);
 		alpm_list_free(all_packages_list);
 		alpm_list_free(foreign_pkg_list);
 		all_packages_list = NULL;
@@ -35,9 +35,24 @@ alpm_handle_t *get_alpm_handle(void);
 alpm_db_t *get_local_db(void);
 alpm_list_t *get_all_packages(void);
 alpm_pkg_t *find_package(const gchar *pkg_name);
+gboolean dep_satisfied_by(const gchar *name, const gchar *version, alpm_list_t *provides, const alpm_depend_t *dep);
+gboolean pkg_satisfies_dep(alpm_pkg_t *pkg, const alpm_depend_t *dep);
+alpm_pkg_t *find_dep_satisfier(const alpm_depend_t *dep);
 alpm_pkg_t *find_satisfier(const gchar *dep_str);
+GPtrArray *find_local_candidates(const gchar *name);
+alpm_list_t *find_local_satisfiers(const alpm_depend_t *dep);
+GPtrArray *find_providers(const gchar *name);
+GPtrArray *get_repo_versions(const gchar *name);
+gboolean is_pkg_shadowed(alpm_pkg_t *pkg);
+const gchar *get_pkg_base(alpm_pkg_t *pkg);
+GPtrArray *get_pkgbases(void);
+GPtrArray *get_pkgbase_members(const gchar *base);
+GPtrArray *get_pkg_conflicted_by(alpm_pkg_t *pkg);
+GPtrArray *get_pkg_replaced_by(alpm_pkg_t *pkg);
 alpm_depend_t *find_pkg_optdep(alpm_pkg_t *pkg, alpm_pkg_t *optpkg);
+install_reason_t get_status_from_relations(const alpm_pkgreason_t reason, const gboolean required, const gboolean optional);
 install_reason_t get_pkg_status(alpm_pkg_t *pkg);
+const gchar *get_status_name(const install_reason_t status);
 void database_free(void);
 
 #endif /* PF_DATABASE_H */
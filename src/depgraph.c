@@ -0,0 +1,975 @@
+/* depgraph.c - PacFinder dependency graph and transitive closure computation
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "depgraph.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <sys/types.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+
+#define UNVISITED G_MAXUINT
+/* below this many packages per thread, starting threads costs more than it saves */
+#define MIN_BROKEN_CHECK_CHUNK 256
+
+/* package fields read once on the main thread, so the workers never call into
+ * libalpm, which lazily loads package data and isn't thread-safe */
+struct pkg_fields_t {
+	const gchar *name;
+	const gchar *version;
+	alpm_list_t *provides;
+	alpm_list_t *depends;
+	alpm_list_t *conflicts;
+};
+
+struct broken_check_t {
+	const struct dep_graph_t *graph;
+	const struct pkg_fields_t *fields;
+	guint start;
+	guint end;
+	bitset_t *broken;
+};
+
+static struct dep_graph_t *full_graph = NULL;
+static struct dep_graph_t *local_graph = NULL;
+
+static struct dep_graph_t *graph_new(alpm_list_t *pkgs)
+{
+	struct dep_graph_t *graph;
+	alpm_list_t *i;
+	guint n;
+
+	graph = g_new0(struct dep_graph_t, 1);
+	graph->ref_count = 1;
+	graph->n_nodes = alpm_list_count(pkgs);
+	graph->pkgs = g_new(alpm_pkg_t *, graph->n_nodes);
+	graph->sizes = g_new(off_t, graph->n_nodes);
+	graph->node_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	for (i = pkgs, n = 0; i; i = alpm_list_next(i), n++) {
+		graph->pkgs[n] = i->data;
+		graph->sizes[n] = alpm_pkg_get_isize(i->data);
+		/* stored off by one so a missing key (NULL) is distinguishable from node 0 */
+		g_hash_table_insert(graph->node_index, i->data, GUINT_TO_POINTER(n + 1));
+	}
+
+	return graph;
+}
+
+/* iterative Tarjan, so deep dependency chains can't overflow the stack. components
+ * are emitted in reverse topological order, which gives the numbering promised
+ * in the header */
+static void compute_components(struct dep_graph_t *graph)
+{
+	const guint n = graph->n_nodes;
+	guint *index = g_new(guint, n);
+	guint *lowlink = g_new(guint, n);
+	gboolean *on_stack = g_new0(gboolean, n);
+	guint *stack = g_new(guint, n);
+	guint *call_node = g_new(guint, n);
+	guint *call_edge = g_new(guint, n);
+	guint stack_len = 0, call_len = 0, next_index = 0;
+	guint *counts, *cursor;
+	guint root, v, c;
+
+	graph->component = g_new(guint, n);
+	graph->n_components = 0;
+
+	for (v = 0; v < n; v++) {
+		index[v] = UNVISITED;
+	}
+
+	for (root = 0; root < n; root++) {
+		if (index[root] != UNVISITED) {
+			continue;
+		}
+
+		index[root] = lowlink[root] = next_index++;
+		stack[stack_len++] = root;
+		on_stack[root] = TRUE;
+		call_node[call_len] = root;
+		call_edge[call_len++] = graph->edge_offsets[root];
+
+		while (call_len > 0) {
+			guint e;
+
+			v = call_node[call_len - 1];
+			e = call_edge[call_len - 1];
+
+			if (e < graph->edge_offsets[v + 1]) {
+				guint w = graph->edges[e];
+
+				call_edge[call_len - 1]++;
+
+				if (index[w] == UNVISITED) {
+					index[w] = lowlink[w] = next_index++;
+					stack[stack_len++] = w;
+					on_stack[w] = TRUE;
+					call_node[call_len] = w;
+					call_edge[call_len++] = graph->edge_offsets[w];
+				} else if (on_stack[w]) {
+					lowlink[v] = MIN(lowlink[v], index[w]);
+				}
+				continue;
+			}
+
+			/* all edges of v are done, v is the root of a component if nothing
+			 * below it reached further up the stack */
+			if (lowlink[v] == index[v]) {
+				guint w;
+
+				do {
+					w = stack[--stack_len];
+					on_stack[w] = FALSE;
+					graph->component[w] = graph->n_components;
+				} while (w != v);
+
+				graph->n_components++;
+			}
+
+			call_len--;
+			if (call_len > 0) {
+				guint parent = call_node[call_len - 1];
+				lowlink[parent] = MIN(lowlink[parent], lowlink[v]);
+			}
+		}
+	}
+
+	/* members of each component */
+	counts = g_new0(guint, graph->n_components + 1);
+	for (v = 0; v < n; v++) {
+		counts[graph->component[v] + 1]++;
+	}
+	for (c = 0; c < graph->n_components; c++) {
+		counts[c + 1] += counts[c];
+	}
+	graph->member_offsets = counts;
+	graph->members = g_new(guint, MAX(n, 1));
+	cursor = g_new(guint, graph->n_components + 1);
+	for (c = 0; c <= graph->n_components; c++) {
+		cursor[c] = counts[c];
+	}
+	for (v = 0; v < n; v++) {
+		graph->members[cursor[graph->component[v]]++] = v;
+	}
+
+	g_free(cursor);
+	g_free(index);
+	g_free(lowlink);
+	g_free(on_stack);
+	g_free(stack);
+	g_free(call_node);
+	g_free(call_edge);
+}
+
+/* collapse edges between nodes into deduplicated edges between components */
+static void compute_condensation(struct dep_graph_t *graph)
+{
+	GArray *dag_edges = g_array_new(FALSE, FALSE, sizeof(guint));
+	guint *last_seen = g_new(guint, MAX(graph->n_components, 1));
+	guint c, m, e;
+
+	graph->dag_offsets = g_new(guint, graph->n_components + 1);
+
+	for (c = 0; c < graph->n_components; c++) {
+		last_seen[c] = UNVISITED;
+	}
+
+	for (c = 0; c < graph->n_components; c++) {
+		graph->dag_offsets[c] = dag_edges->len;
+
+		for (m = graph->member_offsets[c]; m < graph->member_offsets[c + 1]; m++) {
+			guint v = graph->members[m];
+
+			for (e = graph->edge_offsets[v]; e < graph->edge_offsets[v + 1]; e++) {
+				guint target = graph->component[graph->edges[e]];
+
+				if (target != c && last_seen[target] != c) {
+					last_seen[target] = c;
+					g_array_append_val(dag_edges, target);
+				}
+			}
+		}
+	}
+	graph->dag_offsets[graph->n_components] = dag_edges->len;
+	graph->dag_edges = (guint *)g_array_free(dag_edges, FALSE);
+
+	graph->closures = g_new0(bitset_t *, MAX(graph->n_components, 1));
+
+	g_free(last_seen);
+}
+
+static struct dep_graph_t *build_full_graph(void)
+{
+	struct dep_graph_t *graph;
+	GArray *edges;
+	guint *last_seen;
+	guint v;
+
+	graph = graph_new(get_all_packages());
+	edges = g_array_new(FALSE, FALSE, sizeof(guint));
+	last_seen = g_new(guint, MAX(graph->n_nodes, 1));
+	graph->edge_offsets = g_new(guint, graph->n_nodes + 1);
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		last_seen[v] = UNVISITED;
+	}
+
+	/* each dependency resolves to the same package the dependencies tab shows */
+	for (v = 0; v < graph->n_nodes; v++) {
+		alpm_list_t *i;
+
+		graph->edge_offsets[v] = edges->len;
+
+		for (i = alpm_pkg_get_depends(graph->pkgs[v]); i; i = alpm_list_next(i)) {
+			guint target = dep_graph_find_node(graph, find_dep_satisfier(i->data));
+
+			if (target != DEP_GRAPH_NO_NODE && target != v && last_seen[target] != v) {
+				last_seen[target] = v;
+				g_array_append_val(edges, target);
+			}
+		}
+	}
+	graph->edge_offsets[graph->n_nodes] = edges->len;
+	graph->edges = (guint *)g_array_free(edges, FALSE);
+
+	g_free(last_seen);
+
+	compute_components(graph);
+	compute_condensation(graph);
+
+	return graph;
+}
+
+/* reverse of the dependency edges, so dependents can be walked without a search */
+static void compute_dependents(struct dep_graph_t *graph)
+{
+	guint *cursor;
+	guint v, e;
+
+	graph->rev_offsets = g_new0(guint, graph->n_nodes + 1);
+	graph->rev_edges = g_new(guint, MAX(graph->edge_offsets[graph->n_nodes], 1));
+
+	for (e = 0; e < graph->edge_offsets[graph->n_nodes]; e++) {
+		graph->rev_offsets[graph->edges[e] + 1]++;
+	}
+	for (v = 0; v < graph->n_nodes; v++) {
+		graph->rev_offsets[v + 1] += graph->rev_offsets[v];
+	}
+
+	cursor = g_new(guint, graph->n_nodes + 1);
+	for (v = 0; v <= graph->n_nodes; v++) {
+		cursor[v] = graph->rev_offsets[v];
+	}
+	for (v = 0; v < graph->n_nodes; v++) {
+		for (e = graph->edge_offsets[v]; e < graph->edge_offsets[v + 1]; e++) {
+			graph->rev_edges[cursor[graph->edges[e]]++] = v;
+		}
+	}
+
+	g_free(cursor);
+}
+
+/* installed packages only, with an edge to every installed package satisfying a
+ * dependency. this mirrors how pacman decides what a package depends on when
+ * removing, and unlike the full graph it keeps self dependencies. the first of
+ * those satisfiers also gets a first edge */
+static struct dep_graph_t *build_local_graph(void)
+{
+	struct dep_graph_t *graph;
+	GArray *edges, *opt_edges, *first_edges;
+	guint *last_seen, *last_optional, *last_first;
+	guint v, e;
+
+	get_all_packages();
+
+	graph = graph_new(alpm_db_get_pkgcache(get_local_db()));
+	edges = g_array_new(FALSE, FALSE, sizeof(guint));
+	opt_edges = g_array_new(FALSE, FALSE, sizeof(guint));
+	first_edges = g_array_new(FALSE, FALSE, sizeof(guint));
+	last_seen = g_new(guint, MAX(graph->n_nodes, 1));
+	last_optional = g_new(guint, MAX(graph->n_nodes, 1));
+	last_first = g_new(guint, MAX(graph->n_nodes, 1));
+	graph->edge_offsets = g_new(guint, graph->n_nodes + 1);
+	graph->opt_offsets = g_new(guint, graph->n_nodes + 1);
+	graph->first_offsets = g_new(guint, graph->n_nodes + 1);
+	graph->reasons = g_new(alpm_pkgreason_t, MAX(graph->n_nodes, 1));
+	graph->optional_counts = g_new0(guint, MAX(graph->n_nodes, 1));
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		last_seen[v] = UNVISITED;
+		last_optional[v] = UNVISITED;
+		last_first[v] = UNVISITED;
+	}
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		alpm_list_t *i, *satisfiers, *j;
+
+		graph->edge_offsets[v] = edges->len;
+		graph->opt_offsets[v] = opt_edges->len;
+		graph->first_offsets[v] = first_edges->len;
+		graph->reasons[v] = alpm_pkg_get_reason(graph->pkgs[v]);
+
+		for (i = alpm_pkg_get_depends(graph->pkgs[v]); i; i = alpm_list_next(i)) {
+			satisfiers = find_local_satisfiers(i->data);
+			for (j = satisfiers; j; j = alpm_list_next(j)) {
+				guint target = dep_graph_find_node(graph, j->data);
+
+				if (target != DEP_GRAPH_NO_NODE && last_seen[target] != v) {
+					last_seen[target] = v;
+					g_array_append_val(edges, target);
+				}
+				/* satisfiers come in package cache order, like _alpm_find_dep_satisfier() */
+				if (j == satisfiers && target != DEP_GRAPH_NO_NODE && last_first[target] != v) {
+					last_first[target] = v;
+					g_array_append_val(first_edges, target);
+				}
+			}
+			alpm_list_free(satisfiers);
+		}
+
+		for (i = alpm_pkg_get_optdepends(graph->pkgs[v]); i; i = alpm_list_next(i)) {
+			satisfiers = find_local_satisfiers(i->data);
+			for (j = satisfiers; j; j = alpm_list_next(j)) {
+				guint target = dep_graph_find_node(graph, j->data);
+
+				if (target != DEP_GRAPH_NO_NODE && last_optional[target] != v) {
+					last_optional[target] = v;
+					g_array_append_val(opt_edges, target);
+				}
+			}
+			alpm_list_free(satisfiers);
+		}
+	}
+	graph->edge_offsets[graph->n_nodes] = edges->len;
+	graph->edges = (guint *)g_array_free(edges, FALSE);
+	graph->opt_offsets[graph->n_nodes] = opt_edges->len;
+	graph->opt_edges = (guint *)g_array_free(opt_edges, FALSE);
+	graph->first_offsets[graph->n_nodes] = first_edges->len;
+	graph->first_edges = (guint *)g_array_free(first_edges, FALSE);
+
+	/* optional edges are unique per package, so this counts optional dependents */
+	for (e = 0; e < graph->opt_offsets[graph->n_nodes]; e++) {
+		graph->optional_counts[graph->opt_edges[e]]++;
+	}
+
+	g_free(last_seen);
+	g_free(last_optional);
+	g_free(last_first);
+
+	compute_dependents(graph);
+	compute_components(graph);
+	compute_condensation(graph);
+
+	return graph;
+}
+
+struct dep_graph_t *get_dep_graph(void)
+{
+	if (full_graph == NULL) {
+		full_graph = build_full_graph();
+	}
+	return full_graph;
+}
+
+struct dep_graph_t *get_local_dep_graph(void)
+{
+	if (local_graph == NULL) {
+		local_graph = build_local_graph();
+	}
+	return local_graph;
+}
+
+guint dep_graph_find_node(const struct dep_graph_t *graph, alpm_pkg_t *pkg)
+{
+	gpointer value;
+
+	if (pkg == NULL) {
+		return DEP_GRAPH_NO_NODE;
+	}
+
+	value = g_hash_table_lookup(graph->node_index, pkg);
+	return value ? GPOINTER_TO_UINT(value) - 1 : DEP_GRAPH_NO_NODE;
+}
+
+/* accepts the sync db version of a package as well as the installed one */
+guint dep_graph_find_local_node(const struct dep_graph_t *graph, alpm_pkg_t *pkg)
+{
+	if (pkg == NULL) {
+		return DEP_GRAPH_NO_NODE;
+	}
+
+	return dep_graph_find_node(graph, alpm_db_get_pkg(get_local_db(), alpm_pkg_get_name(pkg)));
+}
+
+/* same answer as get_pkg_status(), without recomputing the dependents */
+install_reason_t dep_graph_get_status(const struct dep_graph_t *graph, const guint node)
+{
+	gboolean required, optional;
+
+	g_return_val_if_fail(graph->reasons != NULL && node < graph->n_nodes, PKG_REASON_NOT_INSTALLED);
+
+	required = graph->rev_offsets[node + 1] > graph->rev_offsets[node];
+	optional = graph->optional_counts[node] > 0;
+
+	return get_status_from_relations(graph->reasons[node], required, optional);
+}
+
+/* same as get_pkg_status(), without computing the dependents of the package */
+install_reason_t dep_graph_get_pkg_status(const struct dep_graph_t *graph, alpm_pkg_t *pkg)
+{
+	guint node = dep_graph_find_local_node(graph, pkg);
+
+	if (node == DEP_GRAPH_NO_NODE) {
+		return PKG_REASON_NOT_INSTALLED;
+	}
+	return dep_graph_get_status(graph, node);
+}
+
+/* one multi-source breadth first pass from every explicitly installed package.
+ * required dependencies are followed first so the recorded paths prefer them,
+ * then optional dependencies pick up whatever only those keep installed */
+static void compute_install_parents(struct dep_graph_t *graph)
+{
+	guint *queue;
+	guint head, tail = 0;
+	guint v, e;
+
+	graph->install_parents = g_new(guint, MAX(graph->n_nodes, 1));
+	graph->install_parent_optional = g_new0(gboolean, MAX(graph->n_nodes, 1));
+	queue = g_new(guint, MAX(graph->n_nodes, 1));
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		if (graph->reasons[v] == ALPM_PKG_REASON_EXPLICIT) {
+			graph->install_parents[v] = v;
+			queue[tail++] = v;
+		} else {
+			graph->install_parents[v] = DEP_GRAPH_NO_NODE;
+		}
+	}
+
+	for (head = 0; head < tail; head++) {
+		v = queue[head];
+		for (e = graph->edge_offsets[v]; e < graph->edge_offsets[v + 1]; e++) {
+			guint w = graph->edges[e];
+			if (graph->install_parents[w] == DEP_GRAPH_NO_NODE) {
+				graph->install_parents[w] = v;
+				queue[tail++] = w;
+			}
+		}
+	}
+
+	/* second pass over everything reached so far, and anything it adds */
+	for (head = 0; head < tail; head++) {
+		v = queue[head];
+		for (e = graph->opt_offsets[v]; e < graph->opt_offsets[v + 1]; e++) {
+			guint w = graph->opt_edges[e];
+			if (graph->install_parents[w] == DEP_GRAPH_NO_NODE) {
+				graph->install_parents[w] = v;
+				graph->install_parent_optional[w] = TRUE;
+				queue[tail++] = w;
+			}
+		}
+		for (e = graph->edge_offsets[v]; e < graph->edge_offsets[v + 1]; e++) {
+			guint w = graph->edges[e];
+			if (graph->install_parents[w] == DEP_GRAPH_NO_NODE) {
+				graph->install_parents[w] = v;
+				queue[tail++] = w;
+			}
+		}
+	}
+
+	g_free(queue);
+}
+
+/* anything not reachable from an explicitly installed package over required or
+ * optional dependencies, which includes dependency cycles that only keep each
+ * other installed and whole chains hanging off an orphan */
+const bitset_t *dep_graph_get_recursive_orphans(struct dep_graph_t *graph)
+{
+	guint v;
+
+	g_return_val_if_fail(graph->reasons != NULL, NULL);
+
+	if (graph->recursive_orphans != NULL) {
+		return graph->recursive_orphans;
+	}
+
+	if (graph->install_parents == NULL) {
+		compute_install_parents(graph);
+	}
+
+	graph->recursive_orphans = bitset_new(graph->n_nodes);
+	for (v = 0; v < graph->n_nodes; v++) {
+		if (graph->install_parents[v] == DEP_GRAPH_NO_NODE) {
+			bitset_set(graph->recursive_orphans, v);
+		}
+	}
+
+	return graph->recursive_orphans;
+}
+
+static gboolean is_installed_match(const struct broken_check_t *check, const alpm_depend_t *dep, const guint except)
+{
+	GPtrArray *candidates;
+	guint i;
+
+	candidates = find_local_candidates(dep->name);
+	for (i = 0; candidates != NULL && i < candidates->len; i++) {
+		const struct pkg_fields_t *fields;
+		guint u;
+
+		u = dep_graph_find_node(check->graph, g_ptr_array_index(candidates, i));
+		if (u == DEP_GRAPH_NO_NODE || u == except) {
+			continue;
+		}
+		fields = &check->fields[u];
+		if (dep_satisfied_by(fields->name, fields->version, fields->provides, dep)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gpointer check_broken_range(gpointer data)
+{
+	struct broken_check_t *check = data;
+	guint v;
+
+	for (v = check->start; v < check->end; v++) {
+		const struct pkg_fields_t *fields = &check->fields[v];
+		alpm_list_t *i;
+
+		for (i = fields->depends; i; i = i->next) {
+			if (!is_installed_match(check, i->data, DEP_GRAPH_NO_NODE)) {
+				bitset_set(check->broken, v);
+				break;
+			}
+		}
+
+		/* mark both sides, the other package may not declare the conflict itself */
+		for (i = fields->conflicts; i; i = i->next) {
+			GPtrArray *candidates = find_local_candidates(((alpm_depend_t *)i->data)->name);
+			guint j;
+
+			for (j = 0; candidates != NULL && j < candidates->len; j++) {
+				guint u = dep_graph_find_node(check->graph, g_ptr_array_index(candidates, j));
+
+				if (u != DEP_GRAPH_NO_NODE && u != v && dep_satisfied_by(
+					check->fields[u].name,
+					check->fields[u].version,
+					check->fields[u].provides,
+					i->data
+				)) {
+					bitset_set(check->broken, v);
+					bitset_set(check->broken, u);
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* installed packages with a dependency nothing installed satisfies, or in conflict
+ * with another installed package. the packages are split in ranges between worker
+ * threads, each filling its own set so no writes are shared */
+const bitset_t *dep_graph_get_broken(struct dep_graph_t *graph)
+{
+	struct pkg_fields_t *fields;
+	struct broken_check_t *checks;
+	GThread **threads;
+	gint64 start_time;
+	guint n_threads, chunk, v, i;
+
+	g_return_val_if_fail(graph->reasons != NULL, NULL);
+
+	if (graph->broken != NULL) {
+		return graph->broken;
+	}
+
+	start_time = g_get_monotonic_time();
+
+	fields = g_new(struct pkg_fields_t, graph->n_nodes);
+	for (v = 0; v < graph->n_nodes; v++) {
+		alpm_pkg_t *pkg = graph->pkgs[v];
+
+		fields[v].name = alpm_pkg_get_name(pkg);
+		fields[v].version = alpm_pkg_get_version(pkg);
+		fields[v].provides = alpm_pkg_get_provides(pkg);
+		fields[v].depends = alpm_pkg_get_depends(pkg);
+		fields[v].conflicts = alpm_pkg_get_conflicts(pkg);
+	}
+
+	n_threads = CLAMP(g_get_num_processors(), 1, MAX(graph->n_nodes / MIN_BROKEN_CHECK_CHUNK, 1));
+	chunk = (graph->n_nodes + n_threads - 1) / n_threads;
+	checks = g_new(struct broken_check_t, n_threads);
+	threads = g_new(GThread *, n_threads);
+
+	for (i = 0; i < n_threads; i++) {
+		checks[i].graph = graph;
+		checks[i].fields = fields;
+		checks[i].start = MIN(i * chunk, graph->n_nodes);
+		checks[i].end = MIN(checks[i].start + chunk, graph->n_nodes);
+		checks[i].broken = bitset_new(graph->n_nodes);
+	}
+
+	/* the calling thread takes the first range itself */
+	for (i = 1; i < n_threads; i++) {
+		threads[i] = g_thread_new("pacfinder-check", check_broken_range, &checks[i]);
+	}
+	check_broken_range(&checks[0]);
+
+	graph->broken = checks[0].broken;
+	for (i = 1; i < n_threads; i++) {
+		g_thread_join(threads[i]);
+		bitset_union(graph->broken, checks[i].broken);
+		bitset_free(checks[i].broken);
+	}
+
+	g_free(threads);
+	g_free(checks);
+	g_free(fields);
+
+	g_debug("checked %u installed packages on %u threads in %" G_GINT64_FORMAT " us, %u broken",
+		graph->n_nodes, n_threads, g_get_monotonic_time() - start_time, bitset_count(graph->broken));
+
+	return graph->broken;
+}
+
+/* nodes from an explicitly installed package down to the given node, along one
+ * of the shortest chains of dependencies. NULL when nothing explicit leads there */
+GArray *dep_graph_get_install_path(struct dep_graph_t *graph, const guint node)
+{
+	GArray *path;
+	guint v;
+
+	g_return_val_if_fail(graph->reasons != NULL && node < graph->n_nodes, NULL);
+
+	if (graph->install_parents == NULL) {
+		compute_install_parents(graph);
+	}
+
+	if (graph->install_parents[node] == DEP_GRAPH_NO_NODE) {
+		return NULL;
+	}
+
+	path = g_array_new(FALSE, FALSE, sizeof(guint));
+	for (v = node; graph->install_parents[v] != v; v = graph->install_parents[v]) {
+		g_array_prepend_val(path, v);
+	}
+	g_array_prepend_val(path, v);
+
+	return path;
+}
+
+/* closure of a component is its own members plus the closures of every
+ * component it points at, which must all be built already */
+static void build_component_closure(struct dep_graph_t *graph, const guint component)
+{
+	bitset_t *closure;
+	guint e, m;
+
+	closure = bitset_new(graph->n_nodes);
+	for (m = graph->member_offsets[component]; m < graph->member_offsets[component + 1]; m++) {
+		bitset_set(closure, graph->members[m]);
+	}
+	for (e = graph->dag_offsets[component]; e < graph->dag_offsets[component + 1]; e++) {
+		bitset_union(closure, graph->closures[graph->dag_edges[e]]);
+	}
+
+	graph->closures[component] = closure;
+}
+
+/* the components a closure depends on are built first with an explicit stack,
+ * and each one is kept so any later query reaching it is a lookup */
+static const bitset_t *get_component_closure(struct dep_graph_t *graph, const guint component)
+{
+	GArray *pending;
+
+	if (graph->closures[component] != NULL) {
+		return graph->closures[component];
+	}
+
+	pending = g_array_new(FALSE, FALSE, sizeof(guint));
+	g_array_append_val(pending, component);
+
+	while (pending->len > 0) {
+		guint c = g_array_index(pending, guint, pending->len - 1);
+		gboolean ready = TRUE;
+		guint e;
+
+		if (graph->closures[c] != NULL) {
+			g_array_set_size(pending, pending->len - 1);
+			continue;
+		}
+
+		for (e = graph->dag_offsets[c]; e < graph->dag_offsets[c + 1]; e++) {
+			guint target = graph->dag_edges[e];
+
+			if (graph->closures[target] == NULL) {
+				g_array_append_val(pending, target);
+				ready = FALSE;
+			}
+		}
+
+		if (ready) {
+			build_component_closure(graph, c);
+			g_array_set_size(pending, pending->len - 1);
+		}
+	}
+
+	g_array_free(pending, TRUE);
+
+	return graph->closures[component];
+}
+
+/* fills in every closure in one pass over the condensed graph. components are
+ * numbered dependencies first, so each one only needs closures already built.
+ * afterwards closure queries don't write to the graph, so they are safe to make
+ * from several threads */
+void dep_graph_compute_closures(struct dep_graph_t *graph)
+{
+	guint c;
+
+	for (c = 0; c < graph->n_components; c++) {
+		if (graph->closures[c] == NULL) {
+			build_component_closure(graph, c);
+		}
+	}
+}
+
+const bitset_t *dep_graph_get_closure(struct dep_graph_t *graph, const guint node)
+{
+	g_return_val_if_fail(node < graph->n_nodes, NULL);
+
+	return get_component_closure(graph, graph->component[node]);
+}
+
+/* count excludes the package itself, size includes it */
+void dep_graph_get_closure_stats(struct dep_graph_t *graph, const guint node, guint *count, off_t *size)
+{
+	const bitset_t *closure;
+	guint bit;
+
+	*count = 0;
+	*size = 0;
+
+	closure = dep_graph_get_closure(graph, node);
+	if (closure == NULL) {
+		return;
+	}
+
+	for (bit = 0; bitset_next(closure, &bit); bit++) {
+		*size += graph->sizes[bit];
+		if (bit != node) {
+			(*count)++;
+		}
+	}
+}
+
+/* a dependent breaks when one of its dependencies has no installed satisfier left */
+static gboolean has_unsatisfied_dep(const struct dep_graph_t *graph, const guint node, const bitset_t *removed)
+{
+	alpm_list_t *i, *satisfiers, *j;
+	gboolean broken = FALSE;
+
+	for (i = alpm_pkg_get_depends(graph->pkgs[node]); i && !broken; i = alpm_list_next(i)) {
+		satisfiers = find_local_satisfiers(i->data);
+
+		if (satisfiers != NULL) {
+			broken = TRUE;
+			for (j = satisfiers; j; j = alpm_list_next(j)) {
+				guint target = dep_graph_find_node(graph, j->data);
+
+				if (target == DEP_GRAPH_NO_NODE || !bitset_get(removed, target)) {
+					broken = FALSE;
+					break;
+				}
+			}
+		}
+
+		alpm_list_free(satisfiers);
+	}
+
+	return broken;
+}
+
+static void queue_removal(const struct dep_graph_t *graph, struct removal_t *removal, guint *queue, guint *tail, const guint node)
+{
+	if (graph->reasons[node] != ALPM_PKG_REASON_EXPLICIT && !bitset_get(removal->removed, node)) {
+		bitset_set(removal->removed, node);
+		queue[(*tail)++] = node;
+	}
+}
+
+/* pacman -Rs removes the target, then the first installed satisfier of each
+ * dependency of a removed package, when it wasn't explicitly installed and has no
+ * dependents left outside the removal. instead of recomputing requiredby for every
+ * candidate, each package keeps a count of its dependents that are still installed,
+ * counting every satisfier like requiredby does. a dependency joins the removal
+ * once it has been reached through a first edge and its count is zero, in either
+ * order. checking for broken dependents calls into libalpm, so leave it off when
+ * calling from other threads */
+struct removal_t *dep_graph_simulate_removal(const struct dep_graph_t *graph, const guint node, const gboolean find_broken)
+{
+	struct removal_t *removal;
+	bitset_t *reached;
+	guint *remaining, *queue;
+	guint head = 0, tail = 0;
+	guint v, e;
+
+	g_return_val_if_fail(graph->rev_offsets != NULL && node < graph->n_nodes, NULL);
+
+	removal = g_new0(struct removal_t, 1);
+	removal->removed = bitset_new(graph->n_nodes);
+	removal->broken = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	reached = bitset_new(graph->n_nodes);
+	remaining = g_new(guint, graph->n_nodes);
+	queue = g_new(guint, graph->n_nodes);
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		remaining[v] = graph->rev_offsets[v + 1] - graph->rev_offsets[v];
+	}
+
+	bitset_set(removal->removed, node);
+	queue[tail++] = node;
+
+	while (head < tail) {
+		v = queue[head++];
+		removal->count++;
+		removal->size += graph->sizes[v];
+
+		for (e = graph->edge_offsets[v]; e < graph->edge_offsets[v + 1]; e++) {
+			guint w = graph->edges[e];
+
+			remaining[w]--;
+			if (remaining[w] == 0 && bitset_get(reached, w)) {
+				queue_removal(graph, removal, queue, &tail, w);
+			}
+		}
+		for (e = graph->first_offsets[v]; e < graph->first_offsets[v + 1]; e++) {
+			guint w = graph->first_edges[e];
+
+			bitset_set(reached, w);
+			if (remaining[w] == 0) {
+				queue_removal(graph, removal, queue, &tail, w);
+			}
+		}
+	}
+
+	if (find_broken) {
+		bitset_t *checked = bitset_new(graph->n_nodes);
+
+		for (v = 0; bitset_next(removal->removed, &v); v++) {
+			for (e = graph->rev_offsets[v]; e < graph->rev_offsets[v + 1]; e++) {
+				guint dependent = graph->rev_edges[e];
+
+				if (bitset_get(removal->removed, dependent) || bitset_get(checked, dependent)) {
+					continue;
+				}
+				bitset_set(checked, dependent);
+
+				if (has_unsatisfied_dep(graph, dependent, removal->removed)) {
+					g_array_append_val(removal->broken, dependent);
+				}
+			}
+		}
+
+		bitset_free(checked);
+	}
+
+	bitset_free(reached);
+	g_free(remaining);
+	g_free(queue);
+
+	return removal;
+}
+
+void removal_free(struct removal_t *removal)
+{
+	if (removal != NULL) {
+		bitset_free(removal->removed);
+		g_array_free(removal->broken, TRUE);
+		g_free(removal);
+	}
+}
+
+static void graph_free(struct dep_graph_t *graph)
+{
+	guint c;
+
+	for (c = 0; c < graph->n_components; c++) {
+		bitset_free(graph->closures[c]);
+	}
+	g_free(graph->closures);
+	bitset_free(graph->broken);
+	bitset_free(graph->recursive_orphans);
+	g_free(graph->install_parent_optional);
+	g_free(graph->install_parents);
+	g_free(graph->optional_counts);
+	g_free(graph->reasons);
+	g_free(graph->first_edges);
+	g_free(graph->first_offsets);
+	g_free(graph->opt_edges);
+	g_free(graph->opt_offsets);
+	g_free(graph->rev_edges);
+	g_free(graph->rev_offsets);
+	g_free(graph->dag_edges);
+	g_free(graph->dag_offsets);
+	g_free(graph->members);
+	g_free(graph->member_offsets);
+	g_free(graph->component);
+	g_free(graph->edges);
+	g_free(graph->edge_offsets);
+	g_hash_table_destroy(graph->node_index);
+	g_free(graph->sizes);
+	g_free(graph->pkgs);
+	g_free(graph);
+}
+
+/* a reference keeps a graph usable from another thread after the cached
+ * graphs are dropped. the packages it points to are still released with
+ * the database, so only the index based data may be used after that */
+struct dep_graph_t *dep_graph_ref(struct dep_graph_t *graph)
+{
+	g_atomic_int_inc(&graph->ref_count);
+	return graph;
+}
+
+void dep_graph_unref(struct dep_graph_t *graph)
+{
+	if (graph != NULL && g_atomic_int_dec_and_test(&graph->ref_count)) {
+		graph_free(graph);
+	}
+}
+
+void dep_graph_free(void)
+{
+	g_clear_pointer(&full_graph, dep_graph_unref);
+	g_clear_pointer(&local_graph, dep_graph_unref);
+}
@@ -0,0 +1,106 @@
+/* depgraph.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_DEPGRAPH_H
+#define PF_DEPGRAPH_H
+
+#include <alpm.h>
+#include <glib.h>
+#include <sys/types.h>
+
+#include "bitset.h"
+#include "database.h"
+
+#define DEP_GRAPH_NO_NODE G_MAXUINT
+
+struct dep_graph_t {
+	gint ref_count;
+	guint n_nodes;
+	alpm_pkg_t **pkgs;
+	off_t *sizes;
+	GHashTable *node_index;
+
+	/* dependency edges in compressed row form: the dependencies of node i are
+	 * edges[edge_offsets[i]] up to, but not including, edges[edge_offsets[i + 1]] */
+	guint *edge_offsets;
+	guint *edges;
+
+	/* strongly connected components, numbered so a component's dependencies
+	 * always have lower numbers than the component itself */
+	guint n_components;
+	guint *component;
+	guint *member_offsets;
+	guint *members;
+	guint *dag_offsets;
+	guint *dag_edges;
+
+	/* reachable nodes per component, filled in on first use */
+	bitset_t **closures;
+
+	/* installed packages graph only: dependents and optional dependencies in the
+	 * same compressed row form, install reasons, and how many packages optionally
+	 * depend on each */
+	guint *rev_offsets;
+	guint *rev_edges;
+	guint *opt_offsets;
+	guint *opt_edges;
+	/* the first installed satisfier of each dependency, the only one pacman -Rs
+	 * follows when it looks for dependencies to remove along with a package */
+	guint *first_offsets;
+	guint *first_edges;
+	alpm_pkgreason_t *reasons;
+	guint *optional_counts;
+
+	/* breadth first search tree from the explicitly installed packages, filled in on
+	 * first use. explicit packages are their own parent, unreached packages have
+	 * DEP_GRAPH_NO_NODE, and a flag marks parents that only optionally depend */
+	guint *install_parents;
+	gboolean *install_parent_optional;
+	bitset_t *recursive_orphans;
+
+	/* packages failing the consistency check, filled in on first use */
+	bitset_t *broken;
+};
+
+/* outcome of removing one installed package the way pacman -Rs would */
+struct removal_t {
+	bitset_t *removed;
+	guint count;
+	off_t size;
+	/* nodes of installed packages left with an unsatisfiable dependency */
+	GArray *broken;
+};
+
+struct dep_graph_t *get_dep_graph(void);
+guint dep_graph_find_node(const struct dep_graph_t *graph, alpm_pkg_t *pkg);
+void dep_graph_compute_closures(struct dep_graph_t *graph);
+const bitset_t *dep_graph_get_closure(struct dep_graph_t *graph, const guint node);
+void dep_graph_get_closure_stats(struct dep_graph_t *graph, const guint node, guint *count, off_t *size);
+struct dep_graph_t *get_local_dep_graph(void);
+guint dep_graph_find_local_node(const struct dep_graph_t *graph, alpm_pkg_t *pkg);
+install_reason_t dep_graph_get_status(const struct dep_graph_t *graph, const guint node);
+install_reason_t dep_graph_get_pkg_status(const struct dep_graph_t *graph, alpm_pkg_t *pkg);
+const bitset_t *dep_graph_get_recursive_orphans(struct dep_graph_t *graph);
+const bitset_t *dep_graph_get_broken(struct dep_graph_t *graph);
+GArray *dep_graph_get_install_path(struct dep_graph_t *graph, const guint node);
+struct removal_t *dep_graph_simulate_removal(const struct dep_graph_t *graph, const guint node, const gboolean find_broken);
+void removal_free(struct removal_t *removal);
+struct dep_graph_t *dep_graph_ref(struct dep_graph_t *graph);
+void dep_graph_unref(struct dep_graph_t *graph);
+void dep_graph_free(void);
+
+#endif /* PF_DEPGRAPH_H */
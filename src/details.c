@@ -0,0 +1,333 @@
+/* details.c - PacFinder computed package details and recently viewed package cache
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "details.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+
+/* pacfinder */
+#include "database.h"
+#include "util.h"
+
+#define DETAILS_CACHE_SIZE 64
+
+/* most recently used details are at the head of the queue */
+static GQueue details_queue = G_QUEUE_INIT;
+static GHashTable *details_index = NULL;
+
+static void clear_pkg_dep(gpointer data)
+{
+	struct pkg_dep_t *dep = data;
+
+	g_free(dep->name);
+	g_free(dep->desc);
+	g_free(dep->virtual_name);
+}
+
+static GArray *new_dep_array(void)
+{
+	GArray *arr = g_array_new(FALSE, FALSE, sizeof(struct pkg_dep_t));
+	g_array_set_clear_func(arr, clear_pkg_dep);
+
+	return arr;
+}
+
+static void append_dep(GArray *arr, alpm_pkg_t *pkg, const gchar *label, const gchar *desc, const alpm_depend_t *dep_obj)
+{
+	struct pkg_dep_t dep;
+
+	dep.pkg = pkg;
+	dep.status = get_pkg_status(pkg);
+	dep.name = strtrunc_dep_desc(label);
+	dep.desc = g_strdup(desc);
+	dep.virtual_name = NULL;
+
+	if (dep_obj != NULL && find_package(dep_obj->name) == NULL) {
+		dep.virtual_name = g_strdup(dep_obj->name);
+	}
+
+	g_array_append_val(arr, dep);
+}
+
+static gchar *count_to_string(const size_t count)
+{
+	/* l10n: package dependency counts - %ld will be a number (zero or more) */
+	return g_strdup_printf(ngettext("%ld package", "%ld packages", count), count);
+}
+
+static gchar *date_to_string(const alpm_time_t timestamp)
+{
+	GDateTime *date;
+	gchar *str;
+
+	date = g_date_time_new_from_unix_local(timestamp);
+	str = g_date_time_format_iso8601(date);
+	g_date_time_unref(date);
+
+	return str;
+}
+
+/* comma separated names from one of the reverse indexes, NULL is an empty list */
+static gchar *pkg_array_to_string(const GPtrArray *pkgs)
+{
+	GString *str;
+	guint i;
+
+	str = g_string_new(NULL);
+
+	for (i = 0; pkgs != NULL && i < pkgs->len; i++) {
+		if (i > 0) {
+			g_string_append(str, ", ");
+		}
+		g_string_append(str, alpm_pkg_get_name(g_ptr_array_index(pkgs, i)));
+	}
+
+	return g_string_free(str, FALSE);
+}
+
+/* version in each repository carrying the name, like "testing 1.3-1, core 1.2-1" */
+static gchar *repo_versions_to_string(const gchar *name)
+{
+	GPtrArray *versions;
+	GString *str;
+	guint i;
+
+	versions = get_repo_versions(name);
+	str = g_string_new(NULL);
+
+	for (i = 0; versions != NULL && i < versions->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(versions, i);
+
+		if (i > 0) {
+			g_string_append(str, ", ");
+		}
+		g_string_append_printf(
+			str,
+			"%s %s",
+			alpm_db_get_name(alpm_pkg_get_db(pkg)),
+			alpm_pkg_get_version(pkg)
+		);
+	}
+
+	return g_string_free(str, FALSE);
+}
+
+static void compute_deps(struct pkg_details_t *details)
+{
+	alpm_pkg_t *pkg = details->pkg;
+	alpm_list_t *required_by, *optional_for, *i;
+
+	details->depends = new_dep_array();
+	details->optdepends = new_dep_array();
+	details->required_by = new_dep_array();
+	details->optional_for = new_dep_array();
+
+	/* required dependencies */
+	for (i = alpm_pkg_get_depends(pkg); i; i = alpm_list_next(i)) {
+		gchar *dep_str = alpm_dep_compute_string(i->data);
+		append_dep(details->depends, find_dep_satisfier(i->data), dep_str, NULL, i->data);
+		g_free(dep_str);
+	}
+
+	/* optional dependencies */
+	for (i = alpm_pkg_get_optdepends(pkg); i; i = alpm_list_next(i)) {
+		const alpm_depend_t *dep_obj = i->data;
+		gchar *dep_str = alpm_dep_compute_string(dep_obj);
+		append_dep(details->optdepends, find_dep_satisfier(dep_obj), dep_str, dep_obj->desc, dep_obj);
+		g_free(dep_str);
+	}
+
+	/* required by dependents */
+	required_by = alpm_pkg_compute_requiredby(pkg);
+	for (i = required_by; i; i = alpm_list_next(i)) {
+		append_dep(details->required_by, find_package(i->data), i->data, NULL, NULL);
+	}
+
+	/* optional for dependents */
+	optional_for = alpm_pkg_compute_optionalfor(pkg);
+	for (i = optional_for; i; i = alpm_list_next(i)) {
+		alpm_pkg_t *dep = find_package(i->data);
+		alpm_depend_t *optdep = find_pkg_optdep(pkg, dep);
+		append_dep(details->optional_for, dep, i->data, optdep ? optdep->desc : NULL, NULL);
+	}
+
+	/* these lists are reused as-is by the details tab */
+	details->rows[DETAIL_ROW_REQUIREDBY] = list_to_string(required_by);
+	details->rows[DETAIL_ROW_OPTIONALFOR] = list_to_string(optional_for);
+
+	alpm_list_free_inner(required_by, g_free);
+	alpm_list_free_inner(optional_for, g_free);
+	alpm_list_free(required_by);
+	alpm_list_free(optional_for);
+}
+
+static void compute_overview(struct pkg_details_t *details)
+{
+	alpm_pkg_t *pkg = details->pkg;
+
+	details->status = get_pkg_status(pkg);
+
+	details->heading = g_markup_printf_escaped(
+		"<span size=\"xx-large\">%s</span>\n"
+		"<i>version %s</i>",
+		alpm_pkg_get_name(pkg),
+		alpm_pkg_get_version(pkg)
+	);
+	details->link = g_markup_printf_escaped(
+		"<a href=\"%s\">%s</a>",
+		alpm_pkg_get_url(pkg),
+		alpm_pkg_get_url(pkg)
+	);
+	details->repo = g_strdup(alpm_db_get_name(alpm_pkg_get_db(pkg)));
+
+	details->required_by_count = count_to_string(details->required_by->len);
+	details->optional_for_count = count_to_string(details->optional_for->len);
+	details->depends_count = count_to_string(details->depends->len);
+}
+
+static void compute_rows(struct pkg_details_t *details)
+{
+	alpm_pkg_t *pkg = details->pkg;
+	alpm_pkg_t *local_pkg;
+
+	/* grab local package, if it exists */
+	local_pkg = alpm_db_get_pkg(get_local_db(), alpm_pkg_get_name(pkg));
+
+	details->rows[DETAIL_ROW_NAME] = g_strdup(alpm_pkg_get_name(pkg));
+	details->rows[DETAIL_ROW_VERSION] = g_strdup(alpm_pkg_get_version(pkg));
+	details->rows[DETAIL_ROW_REPOSITORIES] = repo_versions_to_string(alpm_pkg_get_name(pkg));
+	details->rows[DETAIL_ROW_DESC] = g_strdup(alpm_pkg_get_desc(pkg));
+	details->rows[DETAIL_ROW_ARCH] = g_strdup(alpm_pkg_get_arch(pkg));
+	details->rows[DETAIL_ROW_URL] = g_strdup(alpm_pkg_get_url(pkg));
+	details->rows[DETAIL_ROW_LICENSES] = list_to_string(alpm_pkg_get_licenses(pkg));
+	details->rows[DETAIL_ROW_GROUPS] = list_to_string(alpm_pkg_get_groups(pkg));
+	details->rows[DETAIL_ROW_PROVIDES] = deplist_to_string(alpm_pkg_get_provides(pkg));
+	details->rows[DETAIL_ROW_DEPENDS] = deplist_to_string(alpm_pkg_get_depends(pkg));
+	details->rows[DETAIL_ROW_OPTIONALS] = deplist_to_string(alpm_pkg_get_optdepends(pkg));
+	details->rows[DETAIL_ROW_CONFLICTS] = deplist_to_string(alpm_pkg_get_conflicts(pkg));
+	details->rows[DETAIL_ROW_CONFLICTEDBY] = pkg_array_to_string(get_pkg_conflicted_by(pkg));
+	details->rows[DETAIL_ROW_REPLACES] = deplist_to_string(alpm_pkg_get_replaces(pkg));
+	details->rows[DETAIL_ROW_REPLACEDBY] = pkg_array_to_string(get_pkg_replaced_by(pkg));
+	details->rows[DETAIL_ROW_FSIZE] = human_readable_size(alpm_pkg_get_size(pkg));
+	details->rows[DETAIL_ROW_ISIZE] = human_readable_size(alpm_pkg_get_isize(pkg));
+	details->rows[DETAIL_ROW_PACKAGER] = g_strdup(alpm_pkg_get_packager(pkg));
+	details->rows[DETAIL_ROW_BDATE] = date_to_string(alpm_pkg_get_builddate(pkg));
+
+	if (local_pkg != NULL) {
+		details->rows[DETAIL_ROW_IDATE] = date_to_string(alpm_pkg_get_installdate(local_pkg));
+	} else {
+		details->rows[DETAIL_ROW_IDATE] = g_strdup("");
+	}
+}
+
+static struct pkg_details_t *pkg_details_new(alpm_pkg_t *pkg)
+{
+	struct pkg_details_t *details;
+
+	details = g_new0(struct pkg_details_t, 1);
+	details->pkg = pkg;
+
+	compute_deps(details);
+	compute_overview(details);
+	compute_rows(details);
+
+	return details;
+}
+
+static void pkg_details_free(struct pkg_details_t *details)
+{
+	guint i;
+
+	g_free(details->heading);
+	g_free(details->link);
+	g_free(details->repo);
+	g_free(details->required_by_count);
+	g_free(details->optional_for_count);
+	g_free(details->depends_count);
+
+	g_array_unref(details->depends);
+	g_array_unref(details->optdepends);
+	g_array_unref(details->required_by);
+	g_array_unref(details->optional_for);
+
+	for (i = 0; i < DETAIL_NUM_ROWS; i++) {
+		g_free(details->rows[i]);
+	}
+
+	g_free(details);
+}
+
+struct pkg_details_t *get_pkg_details(alpm_pkg_t *pkg)
+{
+	GList *link;
+	struct pkg_details_t *details;
+
+	g_return_val_if_fail(pkg != NULL, NULL);
+
+	if (details_index == NULL) {
+		details_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+
+	link = g_hash_table_lookup(details_index, pkg);
+
+	if (link != NULL) {
+		/* cache hit, mark as most recently used */
+		g_queue_unlink(&details_queue, link);
+		g_queue_push_head_link(&details_queue, link);
+
+		return link->data;
+	}
+
+	details = pkg_details_new(pkg);
+	g_queue_push_head(&details_queue, details);
+	g_hash_table_insert(details_index, pkg, details_queue.head);
+
+	/* evict least recently used */
+	if (details_queue.length > DETAILS_CACHE_SIZE) {
+		struct pkg_details_t *evicted = g_queue_pop_tail(&details_queue);
+		g_hash_table_remove(details_index, evicted->pkg);
+		pkg_details_free(evicted);
+	}
+
+	return details;
+}
+
+gboolean is_pkg_details_cached(alpm_pkg_t *pkg)
+{
+	return details_index != NULL && g_hash_table_contains(details_index, pkg);
+}
+
+void details_cache_free(void)
+{
+	struct pkg_details_t *details;
+
+	while ((details = g_queue_pop_head(&details_queue)) != NULL) {
+		pkg_details_free(details);
+	}
+
+	if (details_index != NULL) {
+		g_hash_table_destroy(details_index);
+		details_index = NULL;
+	}
+}
@@ -0,0 +1,87 @@
+/* details.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_DETAILS_H
+#define PF_DETAILS_H
+
+#include <alpm.h>
+#include <glib.h>
+
+#include "database.h"
+
+enum {
+	DETAIL_ROW_NAME = 0,
+	DETAIL_ROW_VERSION,
+	DETAIL_ROW_REPOSITORIES,
+	DETAIL_ROW_DESC,
+	DETAIL_ROW_ARCH,
+	DETAIL_ROW_URL,
+	DETAIL_ROW_LICENSES,
+	DETAIL_ROW_GROUPS,
+	DETAIL_ROW_PROVIDES,
+	DETAIL_ROW_DEPENDS,
+	DETAIL_ROW_OPTIONALS,
+	DETAIL_ROW_REQUIREDBY,
+	DETAIL_ROW_OPTIONALFOR,
+	DETAIL_ROW_CONFLICTS,
+	DETAIL_ROW_CONFLICTEDBY,
+	DETAIL_ROW_REPLACES,
+	DETAIL_ROW_REPLACEDBY,
+	DETAIL_ROW_FSIZE,
+	DETAIL_ROW_ISIZE,
+	DETAIL_ROW_PACKAGER,
+	DETAIL_ROW_BDATE,
+	DETAIL_ROW_IDATE,
+	DETAIL_NUM_ROWS
+};
+
+struct pkg_dep_t {
+	alpm_pkg_t *pkg;
+	install_reason_t status;
+	gchar *name;
+	gchar *desc;
+	/* dependency name when no package has that name, NULL otherwise */
+	gchar *virtual_name;
+};
+
+struct pkg_details_t {
+	alpm_pkg_t *pkg;
+	install_reason_t status;
+
+	/* overview tab */
+	gchar *heading;
+	gchar *link;
+	gchar *repo;
+	gchar *required_by_count;
+	gchar *optional_for_count;
+	gchar *depends_count;
+
+	/* dependencies and dependents tabs, arrays of struct pkg_dep_t */
+	GArray *depends;
+	GArray *optdepends;
+	GArray *required_by;
+	GArray *optional_for;
+
+	/* details tab */
+	gchar *rows[DETAIL_NUM_ROWS];
+};
+
+struct pkg_details_t *get_pkg_details(alpm_pkg_t *pkg);
+gboolean is_pkg_details_cached(alpm_pkg_t *pkg);
+void details_cache_free(void);
+
+#endif /* PF_DETAILS_H */
@@ -0,0 +1,297 @@
+/* export.c - PacFinder package list and dependency graph export
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "export.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <gio/gio.h>
+#include <glib.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "depgraph.h"
+#include "exportformat.h"
+#include "pkgtable.h"
+
+/* rows read from libalpm per hand-off to the writer thread */
+#define EXPORT_CHUNK_ROWS 4096
+/* chunks in flight, so one is filled while the other is written */
+#define EXPORT_CHUNKS 2
+/* starting size of the text a chunk is written from */
+#define EXPORT_BUFFER_SIZE (1024 * 1024)
+
+struct export_chunk_t {
+	struct export_job_t *job;
+	guint n_rows;
+	struct export_row_t rows[EXPORT_CHUNK_ROWS];
+	/* edges leaving the rows above, graph formats only */
+	GArray *edges;
+};
+
+/* the writer thread pops filled chunks and hands each back to the main thread to
+ * be refilled, memory use stays the same however many packages are exported */
+struct export_job_t {
+	GFile *file;
+	export_format_t format;
+	const struct pkg_table_t *table;
+	struct dep_graph_t *local_graph;
+	bitset_t *rows;
+	/* next row to read, only used on the main thread */
+	guint next_row;
+	GAsyncQueue *filled;
+	struct export_chunk_t *chunks[EXPORT_CHUNKS];
+};
+
+/* a dependency edge goes to the package find_satisfier() would pick, which is an
+ * index lookup, so resolving every edge stays linear in the number of edges */
+static void add_edge(struct export_chunk_t *chunk, const guint source, alpm_pkg_t *target_pkg, const edge_type_t type)
+{
+	struct export_job_t *job = chunk->job;
+
+	if (target_pkg != NULL) {
+		export_add_edge(chunk->edges, job->rows, source, pkg_table_find_row(job->table, target_pkg), type);
+	}
+}
+
+/* provides edges point at real packages of a provided name, virtual names
+ * like "sh" have no node of their own */
+static void add_pkg_edges(struct export_chunk_t *chunk, const guint row, alpm_pkg_t *pkg)
+{
+	alpm_list_t *i;
+
+	for (i = alpm_pkg_get_depends(pkg); i; i = alpm_list_next(i)) {
+		add_edge(chunk, row, find_dep_satisfier(i->data), EDGE_DEPENDS);
+	}
+	for (i = alpm_pkg_get_optdepends(pkg); i; i = alpm_list_next(i)) {
+		add_edge(chunk, row, find_dep_satisfier(i->data), EDGE_OPTDEPENDS);
+	}
+	for (i = alpm_pkg_get_provides(pkg); i; i = alpm_list_next(i)) {
+		const alpm_depend_t *prov = i->data;
+
+		if (g_strcmp0(prov->name, alpm_pkg_get_name(pkg)) != 0) {
+			add_edge(chunk, row, find_package(prov->name), EDGE_PROVIDES);
+		}
+	}
+}
+
+/* the installed date is read from the local package, the table holds the sync
+ * package for anything installed from a repository */
+void export_read_row(const struct pkg_table_t *table, struct dep_graph_t *local_graph,
+                     const guint row, struct export_row_t *out)
+{
+	alpm_pkg_t *pkg = table->pkgs[row];
+	guint node = table->local_nodes[row];
+
+	out->row = row;
+	out->name = alpm_pkg_get_name(pkg);
+	out->version = alpm_pkg_get_version(pkg);
+	out->repo = alpm_db_get_name(alpm_pkg_get_db(pkg));
+	out->status = table->statuses[row];
+	out->size = table->sizes[row];
+	out->download_size = alpm_pkg_get_origin(pkg) == ALPM_PKG_FROM_SYNCDB ? alpm_pkg_get_size(pkg) : -1;
+	out->description = alpm_pkg_get_desc(pkg);
+	out->packager = alpm_pkg_get_packager(pkg);
+	out->built = alpm_pkg_get_builddate(pkg);
+	out->installed = node != DEP_GRAPH_NO_NODE ? alpm_pkg_get_installdate(local_graph->pkgs[node]) : 0;
+	out->depends = alpm_pkg_get_depends(pkg);
+	out->optdepends = alpm_pkg_get_optdepends(pkg);
+}
+
+static void fill_chunk(struct export_chunk_t *chunk)
+{
+	struct export_job_t *job = chunk->job;
+	const struct pkg_table_t *table = job->table;
+	guint row;
+
+	chunk->n_rows = 0;
+	if (chunk->edges != NULL) {
+		g_array_set_size(chunk->edges, 0);
+	}
+
+	for (row = job->next_row; chunk->n_rows < EXPORT_CHUNK_ROWS && bitset_next(job->rows, &row); row++) {
+		export_read_row(table, job->local_graph, row, &chunk->rows[chunk->n_rows++]);
+
+		if (chunk->edges != NULL) {
+			add_pkg_edges(chunk, row, table->pkgs[row]);
+		}
+	}
+
+	job->next_row = row;
+	g_async_queue_push(job->filled, chunk);
+}
+
+static gboolean on_chunk_written(gpointer user_data)
+{
+	fill_chunk(user_data);
+	return G_SOURCE_REMOVE;
+}
+
+/* each chunk is appended to a string and written out whole, the string keeps its
+ * allocation so writes stay large without a buffered stream */
+static void write_chunk(GOutputStream *out, GString *text, GCancellable *cancellable, GError **error)
+{
+	if (out != NULL && *error == NULL) {
+		g_output_stream_write_all(out, text->str, text->len, NULL, cancellable, error);
+	}
+	g_string_truncate(text, 0);
+}
+
+static void write_packages(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct export_job_t *job = task_data;
+	GOutputStream *out = NULL;
+	GFileOutputStream *file_out;
+	GString *text = g_string_sized_new(EXPORT_BUFFER_SIZE);
+	GError *error = NULL;
+	guint retired = 0, written = 0, edges = 0;
+	gint64 start_time = g_get_monotonic_time();
+
+	file_out = g_file_replace(job->file, NULL, FALSE, G_FILE_CREATE_REPLACE_DESTINATION, cancellable, &error);
+	if (file_out != NULL) {
+		out = G_OUTPUT_STREAM(file_out);
+	}
+
+	export_append_header(text, job->format);
+
+	/* a chunk is retired when it comes back empty, or right away after a failure.
+	 * waiting for all of them means no refill is left pending when the job is freed */
+	while (retired < EXPORT_CHUNKS) {
+		struct export_chunk_t *chunk = g_async_queue_pop(job->filled);
+		guint i;
+
+		for (i = 0; i < chunk->n_rows && error == NULL; i++) {
+			export_append_row(text, job->format, &chunk->rows[i], written++);
+		}
+		/* an edge may lead to a node of a later chunk, both formats allow that */
+		for (i = 0; chunk->edges != NULL && i < chunk->edges->len && error == NULL; i++) {
+			export_append_edge(text, job->format, &g_array_index(chunk->edges, struct export_edge_t, i));
+			edges++;
+		}
+		write_chunk(out, text, cancellable, &error);
+
+		if (chunk->n_rows == 0 || error != NULL) {
+			retired++;
+		} else {
+			g_main_context_invoke(NULL, on_chunk_written, chunk);
+		}
+	}
+
+	export_append_footer(text, job->format, written);
+	write_chunk(out, text, cancellable, &error);
+	g_string_free(text, TRUE);
+
+	if (out != NULL) {
+		if (error == NULL) {
+			/* closing moves the file into place */
+			g_output_stream_close(out, cancellable, &error);
+		} else {
+			/* closing cancelled leaves whatever was there before untouched */
+			GCancellable *abandon = g_cancellable_new();
+
+			g_cancellable_cancel(abandon);
+			g_output_stream_close(out, abandon, NULL);
+			g_object_unref(abandon);
+		}
+		g_object_unref(out);
+	}
+
+	if (error != NULL) {
+		g_task_return_error(task, error);
+		return;
+	}
+
+	g_debug("exported %u packages and %u edges in %" G_GINT64_FORMAT " us",
+		written, edges, g_get_monotonic_time() - start_time);
+	g_task_return_int(task, written);
+}
+
+static void free_export_job(gpointer data)
+{
+	struct export_job_t *job = data;
+	guint i;
+
+	for (i = 0; i < EXPORT_CHUNKS; i++) {
+		if (job->chunks[i]->edges != NULL) {
+			g_array_free(job->chunks[i]->edges, TRUE);
+		}
+		g_free(job->chunks[i]);
+	}
+	g_async_queue_unref(job->filled);
+	bitset_free(job->rows);
+	dep_graph_unref(job->local_graph);
+	g_object_unref(job->file);
+	g_free(job);
+}
+
+static gboolean is_graph_format(const export_format_t format)
+{
+	return format == EXPORT_FORMAT_DOT || format == EXPORT_FORMAT_GRAPHML;
+}
+
+/* writes the given rows of the package table, or every row when rows is NULL, which
+ * is taken over. graph formats write the rows as nodes along with the edges between
+ * them. packages are read a chunk at a time on the main thread and written out on a
+ * worker thread, the package data must not be reloaded or freed until the callback
+ * has run. that holds after cancelling too, the main loop has to keep running until
+ * then since the writer is fed from it */
+void export_packages(GFile *file, const export_format_t format, bitset_t *rows, GCancellable *cancellable,
+                     GAsyncReadyCallback callback, gpointer user_data)
+{
+	struct export_job_t *job;
+	GTask *task;
+	guint i;
+
+	job = g_new0(struct export_job_t, 1);
+	job->file = g_object_ref(file);
+	job->format = format;
+	job->table = get_pkg_table();
+	job->local_graph = dep_graph_ref(get_local_dep_graph());
+	job->filled = g_async_queue_new();
+
+	if (rows != NULL) {
+		job->rows = rows;
+	} else {
+		job->rows = bitset_new(job->table->n_rows);
+		bitset_fill(job->rows);
+	}
+
+	/* the first chunks are ready before the writer starts */
+	for (i = 0; i < EXPORT_CHUNKS; i++) {
+		job->chunks[i] = g_new(struct export_chunk_t, 1);
+		job->chunks[i]->job = job;
+		job->chunks[i]->edges = is_graph_format(format)
+			? g_array_new(FALSE, FALSE, sizeof(struct export_edge_t)) : NULL;
+		fill_chunk(job->chunks[i]);
+	}
+
+	task = g_task_new(NULL, cancellable, callback, user_data);
+	g_task_set_task_data(task, job, free_export_job);
+	g_task_run_in_thread(task, write_packages);
+	g_object_unref(task);
+}
+
+/* the number of packages written, or -1 with error set */
+gssize export_packages_finish(GAsyncResult *result, GError **error)
+{
+	return g_task_propagate_int(G_TASK(result), error);
+}
@@ -0,0 +1,37 @@
+/* export.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_EXPORT_H
+#define PF_EXPORT_H
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "bitset.h"
+
+typedef enum {
+	EXPORT_FORMAT_CSV = 0,
+	EXPORT_FORMAT_JSON,
+	EXPORT_FORMAT_DOT,
+	EXPORT_FORMAT_GRAPHML
+} export_format_t;
+
+void export_packages(GFile *file, const export_format_t format, bitset_t *rows, GCancellable *cancellable,
+                     GAsyncReadyCallback callback, gpointer user_data);
+gssize export_packages_finish(GAsyncResult *result, GError **error);
+
+#endif /* PF_EXPORT_H */
@@ -0,0 +1,431 @@
+/* exportformat.c - PacFinder export file formats, written from rows read beforehand
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "exportformat.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "export.h"
+#include "pkgtable.h"
+
+static const gchar *dep_mod_strings[] = {
+	[ALPM_DEP_MOD_ANY] = "",
+	[ALPM_DEP_MOD_EQ] = "=",
+	[ALPM_DEP_MOD_GE] = ">=",
+	[ALPM_DEP_MOD_LE] = "<=",
+	[ALPM_DEP_MOD_GT] = ">",
+	[ALPM_DEP_MOD_LT] = "<"
+};
+
+static const gchar *edge_type_names[] = {
+	[EDGE_DEPENDS] = "depends",
+	[EDGE_OPTDEPENDS] = "optdepends",
+	[EDGE_PROVIDES] = "provides"
+};
+
+static const gchar *dot_edge_styles[] = {
+	[EDGE_DEPENDS] = "solid",
+	[EDGE_OPTDEPENDS] = "dashed",
+	[EDGE_PROVIDES] = "dotted"
+};
+
+static const gchar csv_header[] =
+	"name,version,repo,status,size,download_size,description,packager,built,installed,depends,optdepends\n";
+
+static const gchar dot_header[] =
+	"digraph packages {\n"
+	"\tnode [shape=box];\n";
+
+static const gchar graphml_header[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+	"  <key id=\"name\" for=\"node\" attr.name=\"name\" attr.type=\"string\"/>\n"
+	"  <key id=\"version\" for=\"node\" attr.name=\"version\" attr.type=\"string\"/>\n"
+	"  <key id=\"repo\" for=\"node\" attr.name=\"repo\" attr.type=\"string\"/>\n"
+	"  <key id=\"status\" for=\"node\" attr.name=\"status\" attr.type=\"string\"/>\n"
+	"  <key id=\"size\" for=\"node\" attr.name=\"size\" attr.type=\"long\"/>\n"
+	"  <key id=\"type\" for=\"edge\" attr.name=\"type\" attr.type=\"string\"/>\n"
+	"  <graph id=\"packages\" edgedefault=\"directed\">\n";
+
+/* utc, in iso 8601 form so spreadsheets pick it up as a date */
+static void append_date(GString *out, const gint64 timestamp)
+{
+	gchar buf[32];
+	struct tm tm;
+	time_t t = timestamp;
+
+	if (gmtime_r(&t, &tm) != NULL) {
+		g_string_append_len(out, buf, strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm));
+	}
+}
+
+/* appends the runs between characters that need escaping as they are, escape
+ * returns the replacement for a character or NULL to keep it */
+void export_append_escaped(GString *out, const gchar *str,
+                           const gchar *(*escape)(const gchar c, gchar *buf))
+{
+	const gchar *run = str;
+	const gchar *c;
+
+	for (c = str; *c != '\0'; c++) {
+		gchar buf[8];
+		const gchar *replacement = escape(*c, buf);
+
+		if (replacement != NULL) {
+			g_string_append_len(out, run, c - run);
+			g_string_append(out, replacement);
+			run = c + 1;
+		}
+	}
+
+	g_string_append_len(out, run, c - run);
+}
+
+const gchar *export_csv_escape(const gchar c, gchar *buf)
+{
+	return c == '"' ? "\"\"" : NULL;
+}
+
+const gchar *export_json_escape(const gchar c, gchar *buf)
+{
+	switch (c) {
+		case '"':
+			return "\\\"";
+		case '\\':
+			return "\\\\";
+		case '\n':
+			return "\\n";
+		case '\t':
+			return "\\t";
+		default:
+			if ((guchar)c >= 0x20) {
+				return NULL;
+			}
+			g_snprintf(buf, 8, "\\u%04x", (guchar)c);
+			return buf;
+	}
+}
+
+/* inside a quoted dot id */
+const gchar *export_dot_escape(const gchar c, gchar *buf)
+{
+	switch (c) {
+		case '"':
+			return "\\\"";
+		case '\\':
+			return "\\\\";
+		case '\n':
+			return "\\n";
+		default:
+			return NULL;
+	}
+}
+
+const gchar *export_xml_escape(const gchar c, gchar *buf)
+{
+	switch (c) {
+		case '&':
+			return "&amp;";
+		case '<':
+			return "&lt;";
+		case '>':
+			return "&gt;";
+		case '"':
+			return "&quot;";
+		default:
+			return NULL;
+	}
+}
+
+static void append_csv_field(GString *out, const gchar *str)
+{
+	if (str == NULL) {
+		return;
+	}
+
+	if (strpbrk(str, ",\"\r\n") == NULL) {
+		g_string_append(out, str);
+	} else {
+		g_string_append_c(out, '"');
+		export_append_escaped(out, str, export_csv_escape);
+		g_string_append_c(out, '"');
+	}
+}
+
+/* quoted, NULL becomes null */
+void export_append_json_string(GString *out, const gchar *str)
+{
+	if (str == NULL) {
+		g_string_append(out, "null");
+		return;
+	}
+
+	g_string_append_c(out, '"');
+	export_append_escaped(out, str, export_json_escape);
+	g_string_append_c(out, '"');
+}
+
+/* written in the same form as alpm_dep_compute_string(), minus the description */
+static void append_dep(GString *out, const alpm_depend_t *dep,
+                       const gchar *(*escape)(const gchar c, gchar *buf))
+{
+	export_append_escaped(out, dep->name, escape);
+	if (dep->mod != ALPM_DEP_MOD_ANY && dep->version != NULL) {
+		g_string_append(out, dep_mod_strings[dep->mod]);
+		export_append_escaped(out, dep->version, escape);
+	}
+}
+
+/* space separated and always quoted, so nothing in a dependency has to be checked */
+static void append_csv_deps(GString *out, alpm_list_t *deps)
+{
+	alpm_list_t *i;
+
+	g_string_append_c(out, '"');
+	for (i = deps; i; i = alpm_list_next(i)) {
+		if (i != deps) {
+			g_string_append_c(out, ' ');
+		}
+		append_dep(out, i->data, export_csv_escape);
+	}
+	g_string_append_c(out, '"');
+}
+
+static void append_json_deps(GString *out, alpm_list_t *deps)
+{
+	alpm_list_t *i;
+
+	g_string_append_c(out, '[');
+	for (i = deps; i; i = alpm_list_next(i)) {
+		g_string_append(out, i != deps ? ",\"" : "\"");
+		append_dep(out, i->data, export_json_escape);
+		g_string_append_c(out, '"');
+	}
+	g_string_append_c(out, ']');
+}
+
+static void append_csv_row(GString *out, const struct export_row_t *row)
+{
+	append_csv_field(out, row->name);
+	g_string_append_c(out, ',');
+	append_csv_field(out, row->version);
+	g_string_append_c(out, ',');
+	append_csv_field(out, row->repo);
+	g_string_append_c(out, ',');
+	g_string_append(out, get_status_name(row->status));
+	g_string_append_c(out, ',');
+	g_string_append_printf(out, "%" G_GINT64_FORMAT, (gint64)row->size);
+	g_string_append_c(out, ',');
+	if (row->download_size >= 0) {
+		g_string_append_printf(out, "%" G_GINT64_FORMAT, (gint64)row->download_size);
+	}
+	g_string_append_c(out, ',');
+	append_csv_field(out, row->description);
+	g_string_append_c(out, ',');
+	append_csv_field(out, row->packager);
+	g_string_append_c(out, ',');
+	if (row->built > 0) {
+		append_date(out, row->built);
+	}
+	g_string_append_c(out, ',');
+	if (row->installed > 0) {
+		append_date(out, row->installed);
+	}
+	g_string_append_c(out, ',');
+	append_csv_deps(out, row->depends);
+	g_string_append_c(out, ',');
+	append_csv_deps(out, row->optdepends);
+	g_string_append_c(out, '\n');
+}
+
+/* also the rows of --query --format=json */
+static void append_json_row(GString *out, const struct export_row_t *row)
+{
+	g_string_append(out, "{\"name\":");
+	export_append_json_string(out, row->name);
+	g_string_append(out, ",\"version\":");
+	export_append_json_string(out, row->version);
+	g_string_append(out, ",\"repo\":");
+	export_append_json_string(out, row->repo);
+	g_string_append(out, ",\"status\":");
+	export_append_json_string(out, get_status_name(row->status));
+	g_string_append(out, ",\"size\":");
+	g_string_append_printf(out, "%" G_GINT64_FORMAT, (gint64)row->size);
+	g_string_append(out, ",\"download_size\":");
+	if (row->download_size >= 0) {
+		g_string_append_printf(out, "%" G_GINT64_FORMAT, (gint64)row->download_size);
+	} else {
+		g_string_append(out, "null");
+	}
+	g_string_append(out, ",\"description\":");
+	export_append_json_string(out, row->description);
+	g_string_append(out, ",\"packager\":");
+	export_append_json_string(out, row->packager);
+	g_string_append(out, ",\"built\":");
+	g_string_append_printf(out, "%" G_GINT64_FORMAT, row->built);
+	g_string_append(out, ",\"installed\":");
+	if (row->installed > 0) {
+		g_string_append_printf(out, "%" G_GINT64_FORMAT, row->installed);
+	} else {
+		g_string_append(out, "null");
+	}
+	g_string_append(out, ",\"depends\":");
+	append_json_deps(out, row->depends);
+	g_string_append(out, ",\"optdepends\":");
+	append_json_deps(out, row->optdepends);
+	g_string_append_c(out, '}');
+}
+
+/* node ids are table rows, the name alone repeats across repositories */
+static void append_dot_node(GString *out, const struct export_row_t *row)
+{
+	g_string_append_printf(out, "\tn%u [label=\"", row->row);
+	export_append_escaped(out, row->name, export_dot_escape);
+	g_string_append(out, "\", version=\"");
+	export_append_escaped(out, row->version, export_dot_escape);
+	g_string_append(out, "\", repo=\"");
+	export_append_escaped(out, row->repo, export_dot_escape);
+	g_string_append(out, "\", status=\"");
+	g_string_append(out, get_status_name(row->status));
+	g_string_append_printf(out, "\", size=%" G_GINT64_FORMAT "];\n", (gint64)row->size);
+}
+
+static void append_dot_edge(GString *out, const struct export_edge_t *edge)
+{
+	g_string_append_printf(out, "\tn%u -> n%u [type=\"", edge->source, edge->target);
+	g_string_append(out, edge_type_names[edge->type]);
+	g_string_append(out, "\", style=");
+	g_string_append(out, dot_edge_styles[edge->type]);
+	g_string_append(out, "];\n");
+}
+
+static void append_graphml_data(GString *out, const gchar *key, const gchar *value)
+{
+	g_string_append(out, "<data key=\"");
+	g_string_append(out, key);
+	g_string_append(out, "\">");
+	export_append_escaped(out, value, export_xml_escape);
+	g_string_append(out, "</data>");
+}
+
+static void append_graphml_node(GString *out, const struct export_row_t *row)
+{
+	g_string_append_printf(out, "    <node id=\"n%u\">", row->row);
+	append_graphml_data(out, "name", row->name);
+	append_graphml_data(out, "version", row->version);
+	append_graphml_data(out, "repo", row->repo);
+	append_graphml_data(out, "status", get_status_name(row->status));
+	g_string_append_printf(out, "<data key=\"size\">%" G_GINT64_FORMAT "</data></node>\n", (gint64)row->size);
+}
+
+static void append_graphml_edge(GString *out, const struct export_edge_t *edge)
+{
+	g_string_append_printf(out, "    <edge source=\"n%u\" target=\"n%u\">", edge->source, edge->target);
+	append_graphml_data(out, "type", edge_type_names[edge->type]);
+	g_string_append(out, "</edge>\n");
+}
+
+/* keeps an edge only when its target is one of the exported rows, the source always is */
+void export_add_edge(GArray *edges, const bitset_t *rows, const guint source, const guint target, const edge_type_t type)
+{
+	struct export_edge_t edge;
+
+	if (target == PKG_TABLE_NO_ROW || !bitset_get(rows, target)) {
+		return;
+	}
+
+	edge.source = source;
+	edge.target = target;
+	edge.type = type;
+	g_array_append_val(edges, edge);
+}
+
+void export_append_header(GString *out, const export_format_t format)
+{
+	switch (format) {
+		case EXPORT_FORMAT_CSV:
+			g_string_append(out, csv_header);
+			break;
+		case EXPORT_FORMAT_JSON:
+			g_string_append_c(out, '[');
+			break;
+		case EXPORT_FORMAT_DOT:
+			g_string_append(out, dot_header);
+			break;
+		case EXPORT_FORMAT_GRAPHML:
+			g_string_append(out, graphml_header);
+			break;
+	}
+}
+
+void export_append_row(GString *out, const export_format_t format,
+                       const struct export_row_t *row, const guint index)
+{
+	switch (format) {
+		case EXPORT_FORMAT_CSV:
+			append_csv_row(out, row);
+			break;
+		case EXPORT_FORMAT_JSON:
+			g_string_append(out, index == 0 ? "\n" : ",\n");
+			append_json_row(out, row);
+			break;
+		case EXPORT_FORMAT_DOT:
+			append_dot_node(out, row);
+			break;
+		case EXPORT_FORMAT_GRAPHML:
+			append_graphml_node(out, row);
+			break;
+	}
+}
+
+void export_append_edge(GString *out, const export_format_t format, const struct export_edge_t *edge)
+{
+	if (format == EXPORT_FORMAT_DOT) {
+		append_dot_edge(out, edge);
+	} else {
+		append_graphml_edge(out, edge);
+	}
+}
+
+void export_append_footer(GString *out, const export_format_t format, const guint written)
+{
+	switch (format) {
+		case EXPORT_FORMAT_CSV:
+			break;
+		case EXPORT_FORMAT_JSON:
+			g_string_append(out, written == 0 ? "]\n" : "\n]\n");
+			break;
+		case EXPORT_FORMAT_DOT:
+			g_string_append(out, "}\n");
+			break;
+		case EXPORT_FORMAT_GRAPHML:
+			g_string_append(out, "  </graph>\n</graphml>\n");
+			break;
+	}
+}
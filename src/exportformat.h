@@ -0,0 +1,83 @@
+/* exportformat.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_EXPORTFORMAT_H
+#define PF_EXPORTFORMAT_H
+
+#include <alpm.h>
+#include <glib.h>
+#include <sys/types.h>
+
+#include "bitset.h"
+#include "database.h"
+#include "depgraph.h"
+#include "export.h"
+#include "pkgtable.h"
+
+/* package fields read on the main thread, since libalpm lazily loads package data
+ * and isn't thread-safe. strings and lists still belong to libalpm, nothing is
+ * copied */
+struct export_row_t {
+	guint row;
+	const gchar *name;
+	const gchar *version;
+	const gchar *repo;
+	install_reason_t status;
+	off_t size;
+	/* -1 for packages only found in the local database */
+	off_t download_size;
+	const gchar *description;
+	const gchar *packager;
+	gint64 built;
+	/* 0 for uninstalled packages */
+	gint64 installed;
+	alpm_list_t *depends;
+	alpm_list_t *optdepends;
+};
+
+typedef enum {
+	EDGE_DEPENDS = 0,
+	EDGE_OPTDEPENDS,
+	EDGE_PROVIDES
+} edge_type_t;
+
+/* between the rows of two packages that are both exported */
+struct export_edge_t {
+	guint source;
+	guint target;
+	edge_type_t type;
+};
+
+const gchar *export_csv_escape(const gchar c, gchar *buf);
+const gchar *export_json_escape(const gchar c, gchar *buf);
+const gchar *export_dot_escape(const gchar c, gchar *buf);
+const gchar *export_xml_escape(const gchar c, gchar *buf);
+void export_append_escaped(GString *out, const gchar *str,
+                           const gchar *(*escape)(const gchar c, gchar *buf));
+void export_append_json_string(GString *out, const gchar *str);
+void export_add_edge(GArray *edges, const bitset_t *rows, const guint source, const guint target, const edge_type_t type);
+void export_append_header(GString *out, const export_format_t format);
+void export_append_row(GString *out, const export_format_t format,
+                       const struct export_row_t *row, const guint index);
+void export_append_edge(GString *out, const export_format_t format, const struct export_edge_t *edge);
+void export_append_footer(GString *out, const export_format_t format, const guint written);
+
+/* export.c, reads libalpm so it only runs on the main thread */
+void export_read_row(const struct pkg_table_t *table, struct dep_graph_t *local_graph,
+                     const guint row, struct export_row_t *out);
+
+#endif /* PF_EXPORTFORMAT_H */
@@ -0,0 +1,386 @@
+/* facetpanel.c - PacFinder package facet filters
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "facetpanel.h"
+
+/* system libraries */
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "pkgtable.h"
+#include "util.h"
+
+/* the facets listed first in facet_t, repositories and groups already have their
+ * own rows in the categories list */
+#define NUM_PANEL_FACETS (FACET_ARCH + 1)
+
+enum {
+	FACET_COL_VALUE = 0,
+	FACET_COL_COUNT,
+	FACET_NUM_COLS
+};
+
+static struct {
+	facet_changed_func on_changed;
+	gboolean reloading;
+
+	GtkComboBox *combos[NUM_PANEL_FACETS];
+	GtkListStore *stores[NUM_PANEL_FACETS];
+	GtkEntry *from_entries[NUM_DATES];
+	GtkEntry *to_entries[NUM_DATES];
+
+	/* current selection, NULL for any value or an unbounded date range */
+	const struct facet_value_t *selected[NUM_PANEL_FACETS];
+	gint64 from[NUM_DATES];
+	gint64 to[NUM_DATES];
+	bitset_t *date_rows[NUM_DATES];
+
+	/* every selection combined, NULL when nothing is narrowed down */
+	bitset_t *rows;
+} facet_panel;
+
+/* the rows every selection except one facet allows, NULL for all rows */
+static bitset_t *intersect_selections(const gint skip_facet)
+{
+	bitset_t *rows = NULL;
+	const bitset_t *set;
+	gint i;
+
+	for (i = 0; i < NUM_PANEL_FACETS + NUM_DATES; i++) {
+		if (i < NUM_PANEL_FACETS) {
+			set = (i == skip_facet || facet_panel.selected[i] == NULL) ? NULL : facet_panel.selected[i]->rows;
+		} else {
+			set = facet_panel.date_rows[i - NUM_PANEL_FACETS];
+		}
+
+		if (set == NULL) {
+			continue;
+		} else if (rows == NULL) {
+			rows = bitset_copy(set);
+		} else {
+			bitset_intersect(rows, set);
+		}
+	}
+
+	return rows;
+}
+
+/* each value counts the packages it would leave with the other facets as they are,
+ * so picking it never gives a surprise empty list */
+static void update_counts(void)
+{
+	const struct pkg_table_t *table = get_pkg_table();
+	guint f;
+
+	for (f = 0; f < NUM_PANEL_FACETS; f++) {
+		GtkTreeModel *model = GTK_TREE_MODEL(facet_panel.stores[f]);
+		bitset_t *others = intersect_selections(f);
+		GtkTreeIter iter;
+		gboolean valid;
+
+		/* the first row is "any" */
+		valid = gtk_tree_model_get_iter_first(model, &iter);
+		while (valid && gtk_tree_model_iter_next(model, &iter)) {
+			const struct facet_value_t *entry;
+			gchar *value;
+			guint count;
+
+			gtk_tree_model_get(model, &iter, FACET_COL_VALUE, &value, -1);
+			entry = pkg_table_find_value(table, f, value);
+			if (others == NULL) {
+				count = bitset_count(entry->rows);
+			} else {
+				count = bitset_count_intersection(entry->rows, others);
+			}
+			gtk_list_store_set(facet_panel.stores[f], &iter, FACET_COL_COUNT, count, -1);
+			g_free(value);
+		}
+
+		bitset_free(others);
+	}
+
+	bitset_free(facet_panel.rows);
+	facet_panel.rows = intersect_selections(-1);
+}
+
+static void notify_changed(void)
+{
+	update_counts();
+
+	if (facet_panel.on_changed != NULL) {
+		facet_panel.on_changed();
+	}
+}
+
+static void on_combo_changed(GtkComboBox *combo, gpointer user_data)
+{
+	const facet_t facet = GPOINTER_TO_INT(user_data);
+	GtkTreeIter iter;
+	gchar *value = NULL;
+
+	if (facet_panel.reloading) {
+		return;
+	}
+
+	if (gtk_combo_box_get_active_iter(combo, &iter)) {
+		gtk_tree_model_get(gtk_combo_box_get_model(combo), &iter, FACET_COL_VALUE, &value, -1);
+	}
+
+	facet_panel.selected[facet] = value != NULL ? pkg_table_find_value(get_pkg_table(), facet, value) : NULL;
+	g_free(value);
+
+	notify_changed();
+}
+
+/* an empty entry leaves that end of the range open, a date that doesn't parse is
+ * marked and ignored until it does */
+static gint64 read_date_entry(GtkEntry *entry, const gint64 open_end)
+{
+	GtkStyleContext *context = gtk_widget_get_style_context(GTK_WIDGET(entry));
+	const gchar *text = gtk_entry_get_text(entry);
+	gint64 timestamp;
+
+	gtk_style_context_remove_class(context, "error");
+
+	if (*text == '\0') {
+		return open_end;
+	}
+	if (!parse_date(text, &timestamp)) {
+		gtk_style_context_add_class(context, "error");
+		return open_end;
+	}
+
+	return timestamp;
+}
+
+static void on_date_changed(GtkEntry *entry, gpointer user_data)
+{
+	const date_field_t field = GPOINTER_TO_INT(user_data);
+	gint64 from, to;
+
+	if (facet_panel.reloading) {
+		return;
+	}
+
+	from = read_date_entry(facet_panel.from_entries[field], G_MININT64);
+	to = read_date_entry(facet_panel.to_entries[field], G_MAXINT64);
+
+	/* typing a date passes through many that don't parse */
+	if (from == facet_panel.from[field] && to == facet_panel.to[field]) {
+		return;
+	}
+	facet_panel.from[field] = from;
+	facet_panel.to[field] = to;
+
+	g_clear_pointer(&facet_panel.date_rows[field], bitset_free);
+	if (from != G_MININT64 || to != G_MAXINT64) {
+		const struct pkg_table_t *table = get_pkg_table();
+
+		facet_panel.date_rows[field] = bitset_new(table->n_rows);
+		pkg_table_add_date_range(table, field, from, to, facet_panel.date_rows[field]);
+	}
+
+	notify_changed();
+}
+
+static void facet_cell_data_fn(GtkCellLayout *layout, GtkCellRenderer *renderer,
+                               GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	gchar *value, *text;
+	guint count;
+
+	gtk_tree_model_get(model, iter, FACET_COL_VALUE, &value, FACET_COL_COUNT, &count, -1);
+
+	if (value == NULL) {
+		/* l10n: facet filter choice that doesn't narrow the list */
+		g_object_set(renderer, "text", _("Any"), "sensitive", TRUE, NULL);
+	} else {
+		/* l10n: facet filter choice - %s is the value (e.g. a license) and %u the number of packages */
+		text = g_strdup_printf(_("%s (%u)"), value, count);
+		g_object_set(renderer, "text", text, "sensitive", count > 0, NULL);
+		g_free(text);
+	}
+
+	g_free(value);
+}
+
+static GtkWidget *create_facet_label(const gchar *text)
+{
+	GtkWidget *label = gtk_label_new(text);
+
+	gtk_label_set_xalign(GTK_LABEL(label), 0);
+	gtk_style_context_add_class(gtk_widget_get_style_context(label), "dim-label");
+
+	return label;
+}
+
+static void add_facet_row(GtkGrid *grid, const gint row, const facet_t facet, const gchar *title)
+{
+	GtkCellRenderer *renderer;
+
+	facet_panel.stores[facet] = gtk_list_store_new(FACET_NUM_COLS, G_TYPE_STRING, G_TYPE_UINT);
+	facet_panel.combos[facet] = GTK_COMBO_BOX(
+		gtk_combo_box_new_with_model(GTK_TREE_MODEL(facet_panel.stores[facet]))
+	);
+	g_object_unref(facet_panel.stores[facet]);
+
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(facet_panel.combos[facet]), renderer, TRUE);
+	gtk_cell_layout_set_cell_data_func(
+		GTK_CELL_LAYOUT(facet_panel.combos[facet]),
+		renderer,
+		facet_cell_data_fn,
+		NULL,
+		NULL
+	);
+	gtk_widget_set_hexpand(GTK_WIDGET(facet_panel.combos[facet]), TRUE);
+
+	g_signal_connect(
+		facet_panel.combos[facet],
+		"changed",
+		G_CALLBACK(on_combo_changed),
+		GINT_TO_POINTER(facet)
+	);
+
+	gtk_grid_attach(grid, create_facet_label(title), 0, row, 1, 1);
+	gtk_grid_attach(grid, GTK_WIDGET(facet_panel.combos[facet]), 1, row, 2, 1);
+}
+
+static GtkEntry *create_date_entry(const date_field_t field, const gchar *placeholder)
+{
+	GtkEntry *entry = GTK_ENTRY(gtk_entry_new());
+
+	gtk_entry_set_placeholder_text(entry, placeholder);
+	gtk_entry_set_width_chars(entry, 10);
+	g_signal_connect(entry, "changed", G_CALLBACK(on_date_changed), GINT_TO_POINTER(field));
+
+	return entry;
+}
+
+static void add_date_row(GtkGrid *grid, const gint row, const date_field_t field, const gchar *title)
+{
+	/* l10n: placeholders of the facet date range entries, dates are typed as YYYY-MM-DD */
+	facet_panel.from_entries[field] = create_date_entry(field, _("From"));
+	facet_panel.to_entries[field] = create_date_entry(field, _("Before"));
+	facet_panel.from[field] = G_MININT64;
+	facet_panel.to[field] = G_MAXINT64;
+
+	gtk_grid_attach(grid, create_facet_label(title), 0, row, 1, 1);
+	gtk_grid_attach(grid, GTK_WIDGET(facet_panel.from_entries[field]), 1, row, 1, 1);
+	gtk_grid_attach(grid, GTK_WIDGET(facet_panel.to_entries[field]), 2, row, 1, 1);
+}
+
+GtkWidget *create_facet_panel(facet_changed_func on_changed)
+{
+	GtkWidget *expander;
+	GtkGrid *grid;
+
+	facet_panel.on_changed = on_changed;
+
+	grid = GTK_GRID(gtk_grid_new());
+	gtk_grid_set_row_spacing(grid, 4);
+	gtk_grid_set_column_spacing(grid, 4);
+	gtk_container_set_border_width(GTK_CONTAINER(grid), 4);
+
+	/* l10n: facet filter names */
+	add_facet_row(grid, 0, FACET_PACKAGER, _("Packager"));
+	add_facet_row(grid, 1, FACET_LICENSE, _("License"));
+	add_facet_row(grid, 2, FACET_ARCH, _("Architecture"));
+	add_date_row(grid, 3, DATE_BUILD, _("Built"));
+	add_date_row(grid, 4, DATE_INSTALL, _("Installed"));
+
+	gtk_widget_set_tooltip_text(
+		GTK_WIDGET(grid),
+		/* l10n: facet filters tooltip */
+		_("Dates are YYYY, YYYY-MM or YYYY-MM-DD, the range ends before the second date")
+	);
+
+	/* l10n: heading of the facet filters below the categories */
+	expander = gtk_expander_new(_("Filters"));
+	gtk_container_add(GTK_CONTAINER(expander), GTK_WIDGET(grid));
+
+	return expander;
+}
+
+/* forgets the selections made against the previous package table, before it is freed */
+void facet_panel_reset(void)
+{
+	guint i;
+
+	for (i = 0; i < NUM_PANEL_FACETS; i++) {
+		facet_panel.selected[i] = NULL;
+	}
+	for (i = 0; i < NUM_DATES; i++) {
+		facet_panel.from[i] = G_MININT64;
+		facet_panel.to[i] = G_MAXINT64;
+		g_clear_pointer(&facet_panel.date_rows[i], bitset_free);
+	}
+	g_clear_pointer(&facet_panel.rows, bitset_free);
+}
+
+/* fills the facet values from the freshly loaded package table */
+void facet_panel_reload(void)
+{
+	const struct pkg_table_t *table;
+	guint f, i;
+
+	facet_panel_reset();
+	table = get_pkg_table();
+
+	facet_panel.reloading = TRUE;
+
+	for (f = 0; f < NUM_PANEL_FACETS; f++) {
+		GtkListStore *store = facet_panel.stores[f];
+
+		gtk_list_store_clear(store);
+		gtk_list_store_insert_with_values(store, NULL, -1, FACET_COL_VALUE, NULL, FACET_COL_COUNT, 0, -1);
+
+		for (i = 0; i < table->facets[f]->len; i++) {
+			const struct facet_value_t *entry = g_ptr_array_index(table->facets[f], i);
+
+			gtk_list_store_insert_with_values(
+				store, NULL, -1,
+				FACET_COL_VALUE, entry->value,
+				FACET_COL_COUNT, bitset_count(entry->rows),
+				-1
+			);
+		}
+
+		gtk_combo_box_set_active(facet_panel.combos[f], 0);
+	}
+
+	for (f = 0; f < NUM_DATES; f++) {
+		gtk_entry_set_text(facet_panel.from_entries[f], "");
+		gtk_entry_set_text(facet_panel.to_entries[f], "");
+		read_date_entry(facet_panel.from_entries[f], G_MININT64);
+		read_date_entry(facet_panel.to_entries[f], G_MAXINT64);
+	}
+
+	facet_panel.reloading = FALSE;
+}
+
+const bitset_t *facet_panel_get_rows(void)
+{
+	return facet_panel.rows;
+}
@@ -0,0 +1,32 @@
+/* facetpanel.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_FACETPANEL_H
+#define PF_FACETPANEL_H
+
+#include <gtk/gtk.h>
+
+#include "bitset.h"
+
+typedef void (*facet_changed_func)(void);
+
+GtkWidget *create_facet_panel(facet_changed_func on_changed);
+void facet_panel_reset(void);
+void facet_panel_reload(void);
+const bitset_t *facet_panel_get_rows(void);
+
+#endif /* PF_FACETPANEL_H */
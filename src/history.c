@@ -0,0 +1,99 @@
+/* history.c - PacFinder back and forward navigation across viewed packages
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "history.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+
+#define MAX_HISTORY_LENGTH 100
+
+static GPtrArray *entries = NULL;
+static guint position = 0;
+
+void history_push(alpm_pkg_t *pkg)
+{
+	g_return_if_fail(pkg != NULL);
+
+	if (entries == NULL) {
+		entries = g_ptr_array_new();
+	}
+
+	/* selecting the package that is already shown is not a navigation */
+	if (entries->len > 0 && g_ptr_array_index(entries, position) == pkg) {
+		return;
+	}
+
+	/* a new navigation discards anything ahead of the current position */
+	if (entries->len > 0) {
+		g_ptr_array_set_size(entries, position + 1);
+	}
+
+	g_ptr_array_add(entries, pkg);
+
+	if (entries->len > MAX_HISTORY_LENGTH) {
+		g_ptr_array_remove_index(entries, 0);
+	}
+
+	position = entries->len - 1;
+}
+
+alpm_pkg_t *history_back(void)
+{
+	if (!history_can_go_back()) {
+		return NULL;
+	}
+
+	position--;
+
+	return g_ptr_array_index(entries, position);
+}
+
+alpm_pkg_t *history_forward(void)
+{
+	if (!history_can_go_forward()) {
+		return NULL;
+	}
+
+	position++;
+
+	return g_ptr_array_index(entries, position);
+}
+
+gboolean history_can_go_back(void)
+{
+	return entries != NULL && entries->len > 0 && position > 0;
+}
+
+gboolean history_can_go_forward(void)
+{
+	return entries != NULL && position + 1 < entries->len;
+}
+
+void history_clear(void)
+{
+	if (entries != NULL) {
+		g_ptr_array_free(entries, TRUE);
+		entries = NULL;
+	}
+	position = 0;
+}
@@ -0,0 +1,31 @@
+/* history.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_HISTORY_H
+#define PF_HISTORY_H
+
+#include <alpm.h>
+#include <glib.h>
+
+void history_push(alpm_pkg_t *pkg);
+alpm_pkg_t *history_back(void);
+alpm_pkg_t *history_forward(void);
+gboolean history_can_go_back(void);
+gboolean history_can_go_forward(void);
+void history_clear(void);
+
+#endif /* PF_HISTORY_H */
@@ -0,0 +1,168 @@
+/* iconcache.c - PacFinder shared cache of rasterized theme icons
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "iconcache.h"
+
+/* system libraries */
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+/* pacfinder */
+#include "database.h"
+
+/* names are interned, so keys compare by pointer and a lookup allocates nothing */
+struct icon_key_t {
+	const gchar *name;
+	gint size;
+	gint scale;
+};
+
+static GHashTable *icon_cache = NULL;
+
+static guint icon_key_hash(gconstpointer key)
+{
+	const struct icon_key_t *icon_key = key;
+
+	return g_direct_hash(icon_key->name) ^ (guint)icon_key->size ^ ((guint)icon_key->scale << 16);
+}
+
+static gboolean icon_key_equal(gconstpointer a, gconstpointer b)
+{
+	const struct icon_key_t *key_a = a;
+	const struct icon_key_t *key_b = b;
+
+	return key_a->name == key_b->name && key_a->size == key_b->size && key_a->scale == key_b->scale;
+}
+
+static void on_icon_theme_changed(GtkIconTheme *icon_theme, gpointer user_data)
+{
+	/* cached surfaces were rendered from the old theme. cells look icons up as they
+	 * are drawn, and gtk draws every widget again after a theme change */
+	if (icon_cache != NULL) {
+		g_hash_table_remove_all(icon_cache);
+	}
+}
+
+static void initialize_icon_cache(void)
+{
+	icon_cache = g_hash_table_new_full(icon_key_hash, icon_key_equal, g_free, (GDestroyNotify)cairo_surface_destroy);
+
+	g_signal_connect(
+		gtk_icon_theme_get_default(),
+		"changed",
+		G_CALLBACK(on_icon_theme_changed),
+		NULL
+	);
+}
+
+/* the icon rendered for a window scale, with the device scale set so it is drawn at
+ * the given size in logical pixels. NULL if the theme doesn't have it */
+cairo_surface_t *get_icon(const gchar *icon_name, const gint size, const gint scale)
+{
+	struct icon_key_t key, *stored_key;
+	cairo_surface_t *icon;
+	gpointer cached;
+
+	if (icon_cache == NULL) {
+		initialize_icon_cache();
+	}
+
+	key.name = g_intern_string(icon_name);
+	key.size = size;
+	key.scale = scale;
+	if (g_hash_table_lookup_extended(icon_cache, &key, NULL, &cached)) {
+		return cached;
+	}
+
+	icon = gtk_icon_theme_load_surface(
+		gtk_icon_theme_get_default(),
+		icon_name,
+		size,
+		scale,
+		NULL,
+		GTK_ICON_LOOKUP_USE_BUILTIN,
+		NULL
+	);
+
+	if (icon == NULL) {
+		/* l10n: warning message shown in cli or log - %s is the icon name */
+		g_warning(_("Failed to load icon: %s"), icon_name);
+	}
+
+	/* cache takes ownership of the key copy and the surface, a missing icon is
+	 * cached too so it is only reported once */
+	stored_key = g_new(struct icon_key_t, 1);
+	*stored_key = key;
+	g_hash_table_insert(icon_cache, stored_key, icon);
+
+	return icon;
+}
+
+const gchar *get_status_icon_name(const install_reason_t reason)
+{
+	static const gchar *icon_map[] = {
+		[PKG_REASON_NOT_INSTALLED] = "icon-uninstalled",
+		[PKG_REASON_EXPLICIT] = "icon-explicit",
+		[PKG_REASON_DEPEND] = "icon-depend",
+		[PKG_REASON_OPTIONAL] = "icon-optional",
+		[PKG_REASON_ORPHAN] = "icon-orphan"
+	};
+
+	return icon_map[reason];
+}
+
+/* cell data function for a pixbuf renderer showing the icon named in a model column,
+ * the column number is the user data. the name column holds static strings */
+void icon_cell_data_func(GtkCellLayout *cell_layout, GtkCellRenderer *renderer,
+                         GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	const gchar *icon_name;
+	GtkWidget *widget;
+	gint scale = 1;
+
+	gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &icon_name, -1);
+
+	/* tree views lay cells out through their columns, icon views directly */
+	if (GTK_IS_TREE_VIEW_COLUMN(cell_layout)) {
+		widget = gtk_tree_view_column_get_tree_view(GTK_TREE_VIEW_COLUMN(cell_layout));
+	} else {
+		widget = GTK_WIDGET(cell_layout);
+	}
+	if (widget != NULL) {
+		scale = gtk_widget_get_scale_factor(widget);
+	}
+
+	g_object_set(renderer, "surface", icon_name != NULL ? get_icon(icon_name, ICON_SIZE_SMALL, scale) : NULL, NULL);
+}
+
+void icon_cache_free(void)
+{
+	if (icon_cache != NULL) {
+		g_signal_handlers_disconnect_by_func(
+			gtk_icon_theme_get_default(),
+			G_CALLBACK(on_icon_theme_changed),
+			NULL
+		);
+		g_hash_table_destroy(icon_cache);
+		icon_cache = NULL;
+	}
+}
@@ -0,0 +1,33 @@
+/* iconcache.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_ICONCACHE_H
+#define PF_ICONCACHE_H
+
+#include <gtk/gtk.h>
+
+#include "database.h"
+
+#define ICON_SIZE_SMALL 16
+
+cairo_surface_t *get_icon(const gchar *icon_name, const gint size, const gint scale);
+const gchar *get_status_icon_name(const install_reason_t reason);
+void icon_cell_data_func(GtkCellLayout *cell_layout, GtkCellRenderer *renderer,
+                         GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data);
+void icon_cache_free(void);
+
+#endif /* PF_ICONCACHE_H */
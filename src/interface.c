@@ -27,18 +27,31 @@
 
 /* pacfinder */
 #include "database.h"
+#include "iconcache.h"
 
 struct main_window_gui_t main_window_gui;
 
 static GtkWidget *create_header_bar(void)
 {
-	GtkWidget *header_bar, *menu_image;
+	GtkWidget *header_bar, *nav_box, *menu_image;
 
 	header_bar = gtk_header_bar_new();
 	/* l10n: main window title */
 	gtk_header_bar_set_title(GTK_HEADER_BAR(header_bar), _("PacFinder"));
 	gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(header_bar), TRUE);
 
+	main_window_gui.back_button = gtk_button_new_from_icon_name("go-previous-symbolic", GTK_ICON_SIZE_BUTTON);
+	/* l10n: package navigation button tooltips */
+	gtk_widget_set_tooltip_text(main_window_gui.back_button, _("Previous package (Alt+Left)"));
+	main_window_gui.forward_button = gtk_button_new_from_icon_name("go-next-symbolic", GTK_ICON_SIZE_BUTTON);
+	gtk_widget_set_tooltip_text(main_window_gui.forward_button, _("Next package (Alt+Right)"));
+
+	nav_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+	gtk_style_context_add_class(gtk_widget_get_style_context(nav_box), "linked");
+	gtk_box_pack_start(GTK_BOX(nav_box), main_window_gui.back_button, FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(nav_box), main_window_gui.forward_button, FALSE, FALSE, 0);
+	gtk_header_bar_pack_start(GTK_HEADER_BAR(header_bar), nav_box);
+
 	main_window_gui.search_entry = gtk_search_entry_new();
 	gtk_header_bar_pack_start(GTK_HEADER_BAR(header_bar), main_window_gui.search_entry);
 
@@ -63,11 +76,13 @@ static GtkWidget *create_repo_tree(void)
 
 	main_window_gui.repo_tree_store = gtk_tree_store_new(
 		FILTERS_NUM_COLS,
-		GDK_TYPE_PIXBUF,  /* icon */
+		G_TYPE_POINTER,   /* icon name */
 		G_TYPE_STRING,    /* item name */
 		G_TYPE_INT,       /* filters */
 		G_TYPE_POINTER,   /* database */
-		G_TYPE_POINTER    /* group */
+		G_TYPE_POINTER,   /* group */
+		G_TYPE_POINTER,   /* smart filter */
+		G_TYPE_STRING     /* package count */
 	);
 	main_window_gui.repo_treeview = GTK_TREE_VIEW(
 		gtk_tree_view_new_with_model(GTK_TREE_MODEL(main_window_gui.repo_tree_store))
@@ -80,12 +95,23 @@ static GtkWidget *create_repo_tree(void)
 
 	renderer = gtk_cell_renderer_pixbuf_new();
 	gtk_tree_view_column_pack_start(column, renderer, FALSE);
-	gtk_tree_view_column_set_attributes(column, renderer, "pixbuf", FILTERS_COL_ICON, NULL);
+	gtk_cell_layout_set_cell_data_func(
+		GTK_CELL_LAYOUT(column),
+		renderer,
+		icon_cell_data_func,
+		GINT_TO_POINTER(FILTERS_COL_ICON),
+		NULL
+	);
 
 	renderer = gtk_cell_renderer_text_new();
 	gtk_tree_view_column_pack_start(column, renderer, TRUE);
 	gtk_tree_view_column_set_attributes(column, renderer, "text", FILTERS_COL_TITLE, NULL);
 
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "xalign", 1.0, "sensitive", FALSE, NULL);
+	gtk_tree_view_column_pack_end(column, renderer, FALSE);
+	gtk_tree_view_column_set_attributes(column, renderer, "text", FILTERS_COL_COUNT, NULL);
+
 	scrolled_window = gtk_scrolled_window_new(NULL, NULL);
 	gtk_container_add(GTK_CONTAINER(scrolled_window), GTK_WIDGET(main_window_gui.repo_treeview));
 
@@ -117,6 +143,22 @@ static void reason_cell_data_fn(GtkTreeViewColumn *column, GtkCellRenderer *rend
 	}
 }
 
+static void status_icon_cell_data_fn(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                                     GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	GtkWidget *tree_view = gtk_tree_view_column_get_tree_view(column);
+	install_reason_t reason;
+
+	gtk_tree_model_get(model, iter, PACKAGES_COL_STATUS, &reason, -1);
+
+	g_object_set(
+		renderer,
+		"surface",
+		get_icon(get_status_icon_name(reason), ICON_SIZE_SMALL, gtk_widget_get_scale_factor(tree_view)),
+		NULL
+	);
+}
+
 static GtkWidget *create_package_list(void)
 {
 	/* l10n: package list column names */
@@ -131,17 +173,35 @@ static GtkWidget *create_package_list(void)
 		G_TYPE_STRING, /* version */
 		G_TYPE_INT,    /* reason */
 		G_TYPE_STRING, /* repository */
-		G_TYPE_POINTER /* alpm_pkg_t */
+		G_TYPE_POINTER, /* alpm_pkg_t */
+		G_TYPE_STRING, /* pkgbase of a group row */
+		G_TYPE_UINT    /* package table row */
 	);
 
 	main_window_gui.package_list_model = GTK_TREE_MODEL_FILTER(
 		gtk_tree_model_filter_new(GTK_TREE_MODEL(main_window_gui.package_list_store), NULL)
 	);
+
+	/* same columns, rows grouped by pkgbase */
+	main_window_gui.package_group_store = gtk_tree_store_new(
+		PACKAGES_NUM_COLS,
+		G_TYPE_STRING, /* name */
+		G_TYPE_STRING, /* version */
+		G_TYPE_INT,    /* reason */
+		G_TYPE_STRING, /* repository */
+		G_TYPE_POINTER, /* alpm_pkg_t */
+		G_TYPE_STRING, /* pkgbase of a group row */
+		G_TYPE_UINT    /* package table row */
+	);
+
+	main_window_gui.package_group_model = GTK_TREE_MODEL_FILTER(
+		gtk_tree_model_filter_new(GTK_TREE_MODEL(main_window_gui.package_group_store), NULL)
+	);
 	main_window_gui.package_treeview = GTK_TREE_VIEW(
 		gtk_tree_view_new_with_model(GTK_TREE_MODEL(main_window_gui.package_list_model))
 	);
 
-	for (i = 0; i < PACKAGES_NUM_COLS - 1; i++) { /* COLS-1 for the non-visible pointer column */
+	for (i = 0; i < PACKAGES_COL_PKG; i++) { /* stop at the non-visible pointer, pkgbase and row columns */
 		GtkCellRenderer *renderer;
 		GtkTreeViewColumn *column;
 
@@ -156,6 +216,12 @@ static GtkWidget *create_package_list(void)
 
 		if (i == PACKAGES_COL_NAME) {
 			g_object_set(renderer, "weight", PANGO_WEIGHT_BOLD, NULL);
+
+			/* status icon leads the name column */
+			renderer = gtk_cell_renderer_pixbuf_new();
+			gtk_tree_view_column_pack_start(column, renderer, FALSE);
+			gtk_cell_layout_reorder(GTK_CELL_LAYOUT(column), renderer, 0);
+			gtk_tree_view_column_set_cell_data_func(column, renderer, status_icon_cell_data_fn, NULL, NULL);
 		}
 
 		if (i == PACKAGES_COL_STATUS) {
@@ -206,10 +272,19 @@ static GtkWidget *create_package_overview(void)
 	gtk_widget_set_halign(GTK_WIDGET(main_window_gui.details_overview.link_label), GTK_ALIGN_START);
 	gtk_widget_set_margin_bottom(GTK_WIDGET(main_window_gui.details_overview.link_label), 20);
 
+	main_window_gui.details_overview.installed_by_label = GTK_LABEL(gtk_label_new(NULL));
+	gtk_label_set_justify(main_window_gui.details_overview.installed_by_label, GTK_JUSTIFY_LEFT);
+	gtk_label_set_xalign(main_window_gui.details_overview.installed_by_label, 0);
+	gtk_label_set_line_wrap(main_window_gui.details_overview.installed_by_label, TRUE);
+	gtk_widget_set_halign(GTK_WIDGET(main_window_gui.details_overview.installed_by_label), GTK_ALIGN_START);
+	gtk_widget_set_margin_bottom(GTK_WIDGET(main_window_gui.details_overview.installed_by_label), 20);
+	gtk_widget_set_no_show_all(GTK_WIDGET(main_window_gui.details_overview.installed_by_label), TRUE);
+
 	middle_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
 	gtk_box_pack_start(GTK_BOX(middle_vbox), GTK_WIDGET(main_window_gui.details_overview.heading_label), FALSE, FALSE, 0);
 	gtk_box_pack_start(GTK_BOX(middle_vbox), GTK_WIDGET(main_window_gui.details_overview.desc_label), FALSE, FALSE, 0);
 	gtk_box_pack_start(GTK_BOX(middle_vbox), GTK_WIDGET(main_window_gui.details_overview.link_label), FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(middle_vbox), GTK_WIDGET(main_window_gui.details_overview.installed_by_label), FALSE, FALSE, 0);
 	gtk_box_pack_start(GTK_BOX(middle_vbox), aside_hbox, FALSE, FALSE, 0);
 
 	required_by_heading = gtk_label_new(NULL);
@@ -261,14 +336,59 @@ static GtkWidget *create_package_overview(void)
 	return scrolled_window;
 }
 
+static GtkListStore *create_deps_list_store(void)
+{
+	return gtk_list_store_new(
+		DEPS_NUM_COLS,
+		G_TYPE_POINTER, /* status icon name */
+		G_TYPE_STRING,  /* label */
+		G_TYPE_POINTER, /* alpm_pkg_t */
+		G_TYPE_STRING   /* virtual package name */
+	);
+}
+
+static GtkIconView *create_deps_icon_view(GtkListStore *store)
+{
+	GtkIconView *icon_view;
+	GtkCellRenderer *renderer;
+
+	/* icon view only renders the items that are on screen from the model, so packages
+	 * with thousands of dependents don't create thousands of widgets */
+	icon_view = GTK_ICON_VIEW(gtk_icon_view_new_with_model(GTK_TREE_MODEL(store)));
+	gtk_icon_view_set_selection_mode(icon_view, GTK_SELECTION_NONE);
+	gtk_icon_view_set_activate_on_single_click(icon_view, TRUE);
+	gtk_icon_view_set_item_orientation(icon_view, GTK_ORIENTATION_HORIZONTAL);
+	gtk_icon_view_set_item_padding(icon_view, 4);
+	gtk_icon_view_set_margin(icon_view, 4);
+	gtk_icon_view_set_row_spacing(icon_view, 0);
+	gtk_icon_view_set_column_spacing(icon_view, 0);
+	gtk_widget_set_valign(GTK_WIDGET(icon_view), GTK_ALIGN_START);
+	gtk_widget_set_hexpand(GTK_WIDGET(icon_view), TRUE);
+
+	renderer = gtk_cell_renderer_pixbuf_new();
+	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(icon_view), renderer, FALSE);
+	gtk_cell_layout_set_cell_data_func(
+		GTK_CELL_LAYOUT(icon_view),
+		renderer,
+		icon_cell_data_func,
+		GINT_TO_POINTER(DEPS_COL_ICON),
+		NULL
+	);
+
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "xalign", 0.0, NULL);
+	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(icon_view), renderer, TRUE);
+	gtk_cell_layout_set_attributes(GTK_CELL_LAYOUT(icon_view), renderer, "text", DEPS_COL_NAME, NULL);
+
+	return icon_view;
+}
+
 static GtkWidget *create_package_dependencies(void)
 {
 	GtkWidget *requires_label, *optional_label, *grid, *scrolled_window;
 
-	main_window_gui.package_details_deps_box = GTK_FLOW_BOX(gtk_flow_box_new());
-	gtk_flow_box_set_selection_mode(main_window_gui.package_details_deps_box, GTK_SELECTION_NONE);
-	gtk_widget_set_valign(GTK_WIDGET(main_window_gui.package_details_deps_box), GTK_ALIGN_START);
-	gtk_widget_set_hexpand(GTK_WIDGET(main_window_gui.package_details_deps_box), TRUE);
+	main_window_gui.package_details_deps_store = create_deps_list_store();
+	main_window_gui.package_details_deps_view = create_deps_icon_view(main_window_gui.package_details_deps_store);
 
 	/* l10n: labels in package dependencies tab */
 	requires_label = gtk_label_new(_("Requires:"));
@@ -288,7 +408,7 @@ static GtkWidget *create_package_dependencies(void)
 
 	grid = gtk_grid_new();
 	gtk_grid_attach(GTK_GRID(grid), requires_label, 0, 0, 1, 1);
-	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_deps_box), 1, 0, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_deps_view), 1, 0, 1, 1);
 	gtk_grid_attach(GTK_GRID(grid), optional_label, 0, 1, 1, 1);
 	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_opts_grid), 1, 1, 1, 1);
 
@@ -302,10 +422,8 @@ static GtkWidget *create_package_dependents(void)
 {
 	GtkWidget *requires_label, *optional_label, *grid, *scrolled_window;
 
-	main_window_gui.package_details_depsfor_box = GTK_FLOW_BOX(gtk_flow_box_new());
-	gtk_flow_box_set_selection_mode(main_window_gui.package_details_depsfor_box, GTK_SELECTION_NONE);
-	gtk_widget_set_valign(GTK_WIDGET(main_window_gui.package_details_depsfor_box), GTK_ALIGN_START);
-	gtk_widget_set_hexpand(GTK_WIDGET(main_window_gui.package_details_depsfor_box), TRUE);
+	main_window_gui.package_details_depsfor_store = create_deps_list_store();
+	main_window_gui.package_details_depsfor_view = create_deps_icon_view(main_window_gui.package_details_depsfor_store);
 
 	/* l10n: labels in package dependents tab */
 	requires_label = gtk_label_new(_("Required By:"));
@@ -325,7 +443,7 @@ static GtkWidget *create_package_dependents(void)
 
 	grid = gtk_grid_new();
 	gtk_grid_attach(GTK_GRID(grid), requires_label, 0, 0, 1, 1);
-	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_depsfor_box), 1, 0, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_depsfor_view), 1, 0, 1, 1);
 	gtk_grid_attach(GTK_GRID(grid), optional_label, 0, 1, 1, 1);
 	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_details_optsfor_grid), 1, 1, 1, 1);
 
@@ -335,6 +453,109 @@ static GtkWidget *create_package_dependents(void)
 	return scrolled_window;
 }
 
+static GtkWidget *create_package_dep_tree(void)
+{
+	GtkWidget *box, *scrolled_window;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	main_window_gui.package_tree_store = gtk_tree_store_new(
+		DEPTREE_NUM_COLS,
+		G_TYPE_POINTER, /* status icon name */
+		G_TYPE_STRING,  /* name */
+		G_TYPE_STRING,  /* total size */
+		G_TYPE_POINTER  /* alpm_pkg_t, NULL for rows not expanded yet */
+	);
+	main_window_gui.package_tree_treeview = GTK_TREE_VIEW(
+		gtk_tree_view_new_with_model(GTK_TREE_MODEL(main_window_gui.package_tree_store))
+	);
+
+	/* l10n: dependency tree column names */
+	column = gtk_tree_view_column_new();
+	gtk_tree_view_column_set_title(column, _("Package"));
+	renderer = gtk_cell_renderer_pixbuf_new();
+	gtk_tree_view_column_pack_start(column, renderer, FALSE);
+	gtk_cell_layout_set_cell_data_func(
+		GTK_CELL_LAYOUT(column),
+		renderer,
+		icon_cell_data_func,
+		GINT_TO_POINTER(DEPTREE_COL_ICON),
+		NULL
+	);
+	renderer = gtk_cell_renderer_text_new();
+	gtk_tree_view_column_pack_start(column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute(column, renderer, "text", DEPTREE_COL_NAME);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_append_column(main_window_gui.package_tree_treeview, column);
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(_("Total Size"), renderer, "text", DEPTREE_COL_SIZE, NULL);
+	gtk_tree_view_append_column(main_window_gui.package_tree_treeview, column);
+
+	main_window_gui.package_tree_summary_label = GTK_LABEL(gtk_label_new(NULL));
+	gtk_label_set_xalign(main_window_gui.package_tree_summary_label, 0);
+	gtk_widget_set_margin_top(GTK_WIDGET(main_window_gui.package_tree_summary_label), 5);
+	gtk_widget_set_margin_bottom(GTK_WIDGET(main_window_gui.package_tree_summary_label), 5);
+	gtk_widget_set_margin_start(GTK_WIDGET(main_window_gui.package_tree_summary_label), 5);
+	gtk_widget_set_margin_end(GTK_WIDGET(main_window_gui.package_tree_summary_label), 5);
+
+	scrolled_window = gtk_scrolled_window_new(NULL, NULL);
+	gtk_widget_set_vexpand(scrolled_window, TRUE);
+	gtk_container_add(GTK_CONTAINER(scrolled_window), GTK_WIDGET(main_window_gui.package_tree_treeview));
+
+	box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	gtk_container_add(GTK_CONTAINER(box), GTK_WIDGET(main_window_gui.package_tree_summary_label));
+	gtk_container_add(GTK_CONTAINER(box), scrolled_window);
+
+	main_window_gui.package_tree_page = box;
+
+	return box;
+}
+
+static GtkWidget *create_package_removal(void)
+{
+	GtkWidget *removes_label, *breaks_label, *grid, *scrolled_window;
+
+	main_window_gui.package_removal_store = create_deps_list_store();
+	main_window_gui.package_removal_view = create_deps_icon_view(main_window_gui.package_removal_store);
+	main_window_gui.package_removal_broken_store = create_deps_list_store();
+	main_window_gui.package_removal_broken_view = create_deps_icon_view(main_window_gui.package_removal_broken_store);
+
+	main_window_gui.package_removal_summary_label = GTK_LABEL(gtk_label_new(NULL));
+	gtk_label_set_xalign(main_window_gui.package_removal_summary_label, 0);
+	gtk_label_set_line_wrap(main_window_gui.package_removal_summary_label, TRUE);
+	gtk_widget_set_margin_top(GTK_WIDGET(main_window_gui.package_removal_summary_label), 5);
+	gtk_widget_set_margin_start(GTK_WIDGET(main_window_gui.package_removal_summary_label), 5);
+	gtk_widget_set_margin_end(GTK_WIDGET(main_window_gui.package_removal_summary_label), 5);
+
+	/* l10n: labels in package removal tab */
+	removes_label = gtk_label_new(_("Removes:"));
+	gtk_widget_set_valign(removes_label, GTK_ALIGN_START);
+	gtk_widget_set_margin_top(removes_label, 5);
+	gtk_widget_set_margin_start(removes_label, 5);
+	gtk_widget_set_margin_end(removes_label, 5);
+
+	breaks_label = gtk_label_new(_("Breaks:"));
+	gtk_widget_set_valign(breaks_label, GTK_ALIGN_START);
+	gtk_widget_set_margin_top(breaks_label, 5);
+	gtk_widget_set_margin_start(breaks_label, 5);
+	gtk_widget_set_margin_end(breaks_label, 5);
+
+	grid = gtk_grid_new();
+	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_removal_summary_label), 0, 0, 2, 1);
+	gtk_grid_attach(GTK_GRID(grid), removes_label, 0, 1, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_removal_view), 1, 1, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), breaks_label, 0, 2, 1, 1);
+	gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(main_window_gui.package_removal_broken_view), 1, 2, 1, 1);
+
+	scrolled_window = gtk_scrolled_window_new(NULL, NULL);
+	gtk_container_add(GTK_CONTAINER(scrolled_window), grid);
+
+	main_window_gui.package_removal_page = scrolled_window;
+
+	return scrolled_window;
+}
+
 static GtkWidget *create_package_details(void)
 {
 	GtkWidget *scrolled_window, *package_details_treeview;
@@ -397,6 +618,22 @@ static GtkWidget *create_package_info(void)
 		NULL
 	);
 
+	gtk_notebook_append_page_menu(
+		main_window_gui.details_notebook,
+		create_package_dep_tree(),
+		/* l10n: package transitive dependency tree tab name */
+		gtk_label_new(_("Dependency Tree")),
+		NULL
+	);
+
+	gtk_notebook_append_page_menu(
+		main_window_gui.details_notebook,
+		create_package_removal(),
+		/* l10n: package removal impact tab name */
+		gtk_label_new(_("Removal")),
+		NULL
+	);
+
 	gtk_notebook_append_page_menu(
 		main_window_gui.details_notebook,
 		create_package_details(),
@@ -417,7 +654,11 @@ static void create_user_interface(GtkWindow *window)
 	gtk_paned_add2(main_window_gui.vpaned, create_package_info());
 
 	main_window_gui.hpaned = GTK_PANED(gtk_paned_new(GTK_ORIENTATION_HORIZONTAL));
-	gtk_paned_add1(main_window_gui.hpaned, create_repo_tree());
+	/* the facet filters are packed below the categories once the window is set up */
+	main_window_gui.sidebar_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	gtk_box_pack_start(GTK_BOX(main_window_gui.sidebar_box), create_repo_tree(), TRUE, TRUE, 0);
+
+	gtk_paned_add1(main_window_gui.hpaned, main_window_gui.sidebar_box);
 	gtk_paned_add2(main_window_gui.hpaned, GTK_WIDGET(main_window_gui.vpaned));
 
 	gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(main_window_gui.hpaned));
@@ -26,6 +26,8 @@ enum {
 	FILTERS_COL_MASK,
 	FILTERS_COL_DB,
 	FILTERS_COL_GROUP,
+	FILTERS_COL_SMART,
+	FILTERS_COL_COUNT,
 	FILTERS_NUM_COLS
 };
 
@@ -35,9 +37,27 @@ enum {
 	PACKAGES_COL_STATUS,
 	PACAKGES_COL_REPO,
 	PACKAGES_COL_PKG,
+	PACKAGES_COL_BASE,
+	PACKAGES_COL_ROW,
 	PACKAGES_NUM_COLS
 };
 
+enum {
+	DEPS_COL_ICON = 0,
+	DEPS_COL_NAME,
+	DEPS_COL_PKG,
+	DEPS_COL_VIRTUAL,
+	DEPS_NUM_COLS
+};
+
+enum {
+	DEPTREE_COL_ICON = 0,
+	DEPTREE_COL_NAME,
+	DEPTREE_COL_SIZE,
+	DEPTREE_COL_PKG,
+	DEPTREE_NUM_COLS
+};
+
 enum {
 	DETAILS_COL_NAME = 0,
 	DETAILS_COL_VALUE,
@@ -49,6 +69,7 @@ struct details_overview_t {
 	GtkLabel *heading_label;
 	GtkLabel *desc_label;
 	GtkLabel *link_label;
+	GtkLabel *installed_by_label;
 	GtkLabel *left_label;
 	GtkLabel *middle_label;
 	GtkLabel *right_label;
@@ -59,22 +80,39 @@ struct details_overview_t {
 
 struct main_window_gui_t {
 	GtkWindow *window;
+	GtkWidget *back_button;
+	GtkWidget *forward_button;
 	GtkWidget *search_entry;
 	GtkWidget *refresh_button;
 	GtkWidget *menu_button;
 	GtkPaned *hpaned;
 	GtkPaned *vpaned;
+	GtkWidget *sidebar_box;
 	GtkTreeView *repo_treeview;
 	GtkTreeView *package_treeview;
 	GtkTreeStore *repo_tree_store;
 	GtkListStore *package_list_store;
 	GtkTreeModelFilter *package_list_model;
+	GtkTreeStore *package_group_store;
+	GtkTreeModelFilter *package_group_model;
 	GtkNotebook *details_notebook;
 	struct details_overview_t details_overview;
-	GtkFlowBox *package_details_deps_box;
+	GtkIconView *package_details_deps_view;
+	GtkListStore *package_details_deps_store;
 	GtkGrid *package_details_opts_grid;
-	GtkFlowBox *package_details_depsfor_box;
+	GtkIconView *package_details_depsfor_view;
+	GtkListStore *package_details_depsfor_store;
 	GtkGrid *package_details_optsfor_grid;
+	GtkWidget *package_tree_page;
+	GtkLabel *package_tree_summary_label;
+	GtkTreeView *package_tree_treeview;
+	GtkTreeStore *package_tree_store;
+	GtkWidget *package_removal_page;
+	GtkLabel *package_removal_summary_label;
+	GtkIconView *package_removal_view;
+	GtkListStore *package_removal_store;
+	GtkIconView *package_removal_broken_view;
+	GtkListStore *package_removal_broken_store;
 	GtkListStore *package_details_list_store;
 };
 
@@ -26,15 +26,19 @@
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
 #include <locale.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 /* pacfinder */
+#include "cli.h"
 #include "interface.h"
 #include "settings.h"
 #include "window.h"
 
 static struct app_options_t {
 	gboolean show_version;
+	gchar *query;
+	gchar *format;
 } app_options;
 
 static void init_i18n(void)
@@ -60,12 +64,49 @@ static void init_cli_options(GApplication *app, struct app_options_t *options)
 			.description = N_("Show version information"),
 			.arg_description = NULL
 		},
+		{
+			.long_name = "query",
+			.short_name = 'q',
+			.flags = G_OPTION_FLAG_NONE,
+			.arg = G_OPTION_ARG_STRING,
+			.arg_data = &(options->query),
+			.description = N_("Print the packages matching a search query and exit"),
+			/* l10n: cli option value placeholders */
+			.arg_description = N_("QUERY")
+		},
+		{
+			.long_name = "format",
+			.short_name = 0,
+			.flags = G_OPTION_FLAG_NONE,
+			.arg = G_OPTION_ARG_STRING,
+			.arg_data = &(options->format),
+			.description = N_("Output format of --query: text or json"),
+			.arg_description = N_("FORMAT")
+		},
 		{ NULL }
 	};
 
 	g_application_add_main_option_entries(app, cli_options);
 }
 
+/* queries are answered here, before the application starts up gtk */
+static gint on_handle_local_options(GApplication *app, GVariantDict *options, struct app_options_t *app_options)
+{
+	if (app_options->query != NULL) {
+		return run_cli_query(app_options->query, app_options->format);
+	}
+
+	if (app_options->format != NULL) {
+		/* l10n: error message shown in cli */
+		g_printerr(_("--format can only be used with --query"));
+		g_printerr("\n");
+		return EXIT_FAILURE;
+	}
+
+	/* continue with the default handling */
+	return -1;
+}
+
 static void on_activate_app(GtkApplication *app, struct app_options_t *options)
 {
 	if (options->show_version == TRUE) {
@@ -120,10 +161,13 @@ int main(int argc, char **argv)
 
 	/* launch gtk application */
 	app = gtk_application_new(APPLICATION_ID, G_APPLICATION_FLAGS_NONE);
+	g_signal_connect(app, "handle-local-options", G_CALLBACK(on_handle_local_options), &app_options);
 	g_signal_connect(app, "activate", G_CALLBACK(on_activate_app), &app_options);
 	init_cli_options(G_APPLICATION(app), &app_options);
 	status = g_application_run(G_APPLICATION(app), argc, argv);
 	g_object_unref(app);
+	g_free(app_options.query);
+	g_free(app_options.format);
 
 	return status;
 }
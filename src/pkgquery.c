@@ -0,0 +1,216 @@
+/* pkgquery.c - PacFinder search query evaluation over the package table
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "pkgtable.h"
+
+/* system libraries */
+#include <glib.h>
+#include <string.h>
+#include <sys/types.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "query.h"
+#include "util.h"
+
+const struct facet_value_t *pkg_table_find_value(const struct pkg_table_t *table, const facet_t facet, const gchar *value)
+{
+	g_return_val_if_fail(facet < NUM_FACETS, NULL);
+
+	return g_hash_table_lookup(table->facet_index[facet], value);
+}
+
+/* adds the rows dated from the first time up to, but not including, the second */
+void pkg_table_add_date_range(const struct pkg_table_t *table, const date_field_t field,
+                              const gint64 from, const gint64 to, bitset_t *rows)
+{
+	guint start, end, i;
+
+	g_return_if_fail(field < NUM_DATES);
+
+	start = sorted_time_index(table->dates[field], table->n_dates[field], from);
+	end = sorted_time_index(table->dates[field], table->n_dates[field], to);
+
+	for (i = start; i < end; i++) {
+		bitset_set(rows, table->date_rows[field][i]);
+	}
+}
+
+static void apply_rows(bitset_t *result, const bitset_t *rows, const gboolean negate)
+{
+	if (rows == NULL) {
+		/* nothing has the value */
+		if (!negate) {
+			bitset_zero(result);
+		}
+	} else if (negate) {
+		bitset_subtract(result, rows);
+	} else {
+		bitset_intersect(result, rows);
+	}
+}
+
+/* terms answered from the posting lists and sorted dates, as whole sets */
+static gboolean apply_set_term(const struct pkg_table_t *table, const struct query_term_t *term, bitset_t *result)
+{
+	bitset_t *rows = NULL;
+	facet_t facet;
+	guint i;
+
+	switch (term->field) {
+		case QUERY_FIELD_REPO:
+			facet = FACET_REPO;
+			break;
+		case QUERY_FIELD_GROUP:
+			facet = FACET_GROUP;
+			break;
+		case QUERY_FIELD_ARCH:
+			facet = FACET_ARCH;
+			break;
+		case QUERY_FIELD_LICENSE:
+			facet = FACET_LICENSE;
+			break;
+		case QUERY_FIELD_BUILT:
+		case QUERY_FIELD_INSTALLED:
+			rows = bitset_new(table->n_rows);
+			pkg_table_add_date_range(
+				table,
+				term->field == QUERY_FIELD_BUILT ? DATE_BUILD : DATE_INSTALL,
+				term->from,
+				term->to,
+				rows
+			);
+			apply_rows(result, rows, term->negate);
+			bitset_free(rows);
+			return TRUE;
+		default:
+			return FALSE;
+	}
+
+	/* values match ignoring case like names do, so every spelling of one is taken */
+	for (i = 0; i < table->facets[facet]->len; i++) {
+		const struct facet_value_t *entry = g_ptr_array_index(table->facets[facet], i);
+
+		if (g_ascii_strcasecmp(entry->value, term->text) != 0) {
+			continue;
+		}
+		if (rows == NULL) {
+			rows = bitset_copy(entry->rows);
+		} else {
+			bitset_union(rows, entry->rows);
+		}
+	}
+
+	apply_rows(result, rows, term->negate);
+	g_clear_pointer(&rows, bitset_free);
+
+	return TRUE;
+}
+
+static gboolean compare_size(const off_t size, const struct query_term_t *term)
+{
+	switch (term->cmp) {
+		case QUERY_CMP_LT:
+			return size < term->size;
+		case QUERY_CMP_LE:
+			return size <= term->size;
+		case QUERY_CMP_GT:
+			return size > term->size;
+		case QUERY_CMP_GE:
+			return size >= term->size;
+		default:
+			return size == term->size;
+	}
+}
+
+/* terms checked against the columns, row by row */
+static gboolean match_row(const struct pkg_table_t *table, const struct query_term_t *term, const guint row)
+{
+	switch (term->field) {
+		case QUERY_FIELD_STATUS:
+			return (term->status_mask & (1 << table->statuses[row])) != 0;
+		case QUERY_FIELD_SIZE:
+			return compare_size(table->sizes[row], term);
+		case QUERY_FIELD_NAME:
+			return strstr(table->names[row], term->text) != NULL;
+		case QUERY_FIELD_DESC:
+			return strstr(table->descs[row], term->text) != NULL;
+		case QUERY_FIELD_PACKAGER:
+			return strstr(table->packagers[row], term->text) != NULL;
+		default:
+			return TRUE;
+	}
+}
+
+static gboolean is_text_term(const struct query_term_t *term)
+{
+	return term->field == QUERY_FIELD_NAME
+		|| term->field == QUERY_FIELD_DESC
+		|| term->field == QUERY_FIELD_PACKAGER;
+}
+
+/* unsets the given rows not matching every term. set terms go first since they are
+ * whole word operations, then the column scans only visit the rows still left, with
+ * the numeric columns ahead of the text ones */
+void pkg_table_narrow_rows(const struct pkg_table_t *table, const struct query_t *query, bitset_t *result)
+{
+	GPtrArray *scans;
+	guint pass, i, bit;
+
+	scans = g_ptr_array_new();
+
+	for (i = 0; i < query->terms->len; i++) {
+		struct query_term_t *term = g_ptr_array_index(query->terms, i);
+
+		if (!apply_set_term(table, term, result)) {
+			g_ptr_array_add(scans, term);
+		}
+	}
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < scans->len; i++) {
+			const struct query_term_t *term = g_ptr_array_index(scans, i);
+
+			if (is_text_term(term) != (pass == 1)) {
+				continue;
+			}
+
+			for (bit = 0; bitset_next(result, &bit); bit++) {
+				if (match_row(table, term, bit) == term->negate) {
+					bitset_unset(result, bit);
+				}
+			}
+		}
+	}
+
+	g_ptr_array_free(scans, TRUE);
+}
+
+bitset_t *pkg_table_run_query(const struct pkg_table_t *table, const struct query_t *query)
+{
+	bitset_t *result;
+
+	result = bitset_new(table->n_rows);
+	bitset_fill(result);
+	pkg_table_narrow_rows(table, query, result);
+
+	return result;
+}
@@ -0,0 +1,257 @@
+/* pkgtable.c - PacFinder package facet and date indexes
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "pkgtable.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <sys/types.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "depgraph.h"
+
+struct dated_row_t {
+	gint64 date;
+	guint row;
+};
+
+static struct pkg_table_t *pkg_table = NULL;
+
+static void facet_value_free(struct facet_value_t *entry)
+{
+	bitset_free(entry->rows);
+	g_free(entry);
+}
+
+static gint compare_facet_values(gconstpointer a, gconstpointer b)
+{
+	const struct facet_value_t *entry1 = *(struct facet_value_t * const *)a;
+	const struct facet_value_t *entry2 = *(struct facet_value_t * const *)b;
+
+	return g_strcmp0(entry1->value, entry2->value);
+}
+
+static gint compare_dated_rows(gconstpointer a, gconstpointer b)
+{
+	const struct dated_row_t *row1 = a;
+	const struct dated_row_t *row2 = b;
+
+	return (row1->date > row2->date) - (row1->date < row2->date);
+}
+
+/* value strings are owned by libalpm, like the keys of the database indexes */
+static void add_facet_value(struct pkg_table_t *table, const facet_t facet, const gchar *value, const guint row)
+{
+	struct facet_value_t *entry;
+
+	if (value == NULL || *value == '\0') {
+		return;
+	}
+
+	entry = g_hash_table_lookup(table->facet_index[facet], value);
+	if (entry == NULL) {
+		entry = g_new(struct facet_value_t, 1);
+		entry->value = value;
+		entry->rows = bitset_new(table->n_rows);
+		g_hash_table_insert(table->facet_index[facet], (gpointer)value, entry);
+		g_ptr_array_add(table->facets[facet], entry);
+	}
+
+	bitset_set(entry->rows, row);
+}
+
+static void set_dates(struct pkg_table_t *table, const date_field_t field, GArray *dated)
+{
+	guint i;
+
+	g_array_sort(dated, compare_dated_rows);
+
+	table->n_dates[field] = dated->len;
+	table->dates[field] = g_new(gint64, dated->len);
+	table->date_rows[field] = g_new(guint, dated->len);
+
+	for (i = 0; i < dated->len; i++) {
+		const struct dated_row_t *entry = &g_array_index(dated, struct dated_row_t, i);
+
+		table->dates[field][i] = entry->date;
+		table->date_rows[field][i] = entry->row;
+	}
+}
+
+static gchar *lowercase_or_empty(const gchar *str)
+{
+	return str != NULL ? g_ascii_strdown(str, -1) : g_strdup("");
+}
+
+static struct pkg_table_t *table_new(alpm_list_t *pkgs)
+{
+	struct pkg_table_t *table;
+	struct dep_graph_t *local_graph;
+	GArray *dated[NUM_DATES];
+	alpm_list_t *i, *list;
+	guint row, f;
+
+	table = g_new0(struct pkg_table_t, 1);
+	table->n_rows = alpm_list_count(pkgs);
+	table->pkgs = g_new(alpm_pkg_t *, table->n_rows);
+	table->row_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+	table->sizes = g_new(off_t, table->n_rows);
+	table->statuses = g_new(install_reason_t, table->n_rows);
+	table->names = g_new(gchar *, table->n_rows);
+	table->descs = g_new(gchar *, table->n_rows);
+	table->packagers = g_new(gchar *, table->n_rows);
+	table->local_nodes = g_new(guint, table->n_rows);
+	table->shadowed = bitset_new(table->n_rows);
+	local_graph = get_local_dep_graph();
+
+	for (f = 0; f < NUM_FACETS; f++) {
+		table->facets[f] = g_ptr_array_new_with_free_func((GDestroyNotify)facet_value_free);
+		table->facet_index[f] = g_hash_table_new(g_str_hash, g_str_equal);
+	}
+	for (f = 0; f < NUM_DATES; f++) {
+		dated[f] = g_array_sized_new(FALSE, FALSE, sizeof(struct dated_row_t), table->n_rows);
+	}
+
+	for (i = pkgs, row = 0; i; i = alpm_list_next(i), row++) {
+		alpm_pkg_t *pkg = i->data;
+		alpm_pkg_t *local_pkg;
+		struct dated_row_t entry;
+
+		table->pkgs[row] = pkg;
+		/* stored off by one so a missing key (NULL) is distinguishable from row 0 */
+		g_hash_table_insert(table->row_index, pkg, GUINT_TO_POINTER(row + 1));
+
+		add_facet_value(table, FACET_PACKAGER, alpm_pkg_get_packager(pkg), row);
+		add_facet_value(table, FACET_ARCH, alpm_pkg_get_arch(pkg), row);
+		add_facet_value(table, FACET_REPO, alpm_db_get_name(alpm_pkg_get_db(pkg)), row);
+		for (list = alpm_pkg_get_licenses(pkg); list; list = alpm_list_next(list)) {
+			add_facet_value(table, FACET_LICENSE, list->data, row);
+		}
+		for (list = alpm_pkg_get_groups(pkg); list; list = alpm_list_next(list)) {
+			add_facet_value(table, FACET_GROUP, list->data, row);
+		}
+
+		table->sizes[row] = alpm_pkg_get_isize(pkg);
+		table->statuses[row] = dep_graph_get_pkg_status(local_graph, pkg);
+		table->names[row] = lowercase_or_empty(alpm_pkg_get_name(pkg));
+		table->descs[row] = lowercase_or_empty(alpm_pkg_get_desc(pkg));
+		table->packagers[row] = lowercase_or_empty(alpm_pkg_get_packager(pkg));
+		table->local_nodes[row] = dep_graph_find_local_node(local_graph, pkg);
+		if (is_pkg_shadowed(pkg)) {
+			bitset_set(table->shadowed, row);
+		}
+
+		entry.row = row;
+		entry.date = alpm_pkg_get_builddate(pkg);
+		if (entry.date > 0) {
+			g_array_append_val(dated[DATE_BUILD], entry);
+		}
+
+		/* sync packages share the install date of the installed package */
+		local_pkg = alpm_db_get_pkg(get_local_db(), alpm_pkg_get_name(pkg));
+		if (local_pkg != NULL) {
+			entry.date = alpm_pkg_get_installdate(local_pkg);
+			if (entry.date > 0) {
+				g_array_append_val(dated[DATE_INSTALL], entry);
+			}
+		}
+	}
+
+	for (f = 0; f < NUM_FACETS; f++) {
+		g_ptr_array_sort(table->facets[f], compare_facet_values);
+	}
+	for (f = 0; f < NUM_DATES; f++) {
+		set_dates(table, f, dated[f]);
+		g_array_free(dated[f], TRUE);
+	}
+
+	return table;
+}
+
+static void table_free(struct pkg_table_t *table)
+{
+	guint f, row;
+
+	for (row = 0; row < table->n_rows; row++) {
+		g_free(table->names[row]);
+		g_free(table->descs[row]);
+		g_free(table->packagers[row]);
+	}
+	bitset_free(table->shadowed);
+	g_free(table->local_nodes);
+	g_free(table->packagers);
+	g_free(table->descs);
+	g_free(table->names);
+	g_free(table->statuses);
+	g_free(table->sizes);
+
+	for (f = 0; f < NUM_DATES; f++) {
+		g_free(table->date_rows[f]);
+		g_free(table->dates[f]);
+	}
+	for (f = 0; f < NUM_FACETS; f++) {
+		g_hash_table_destroy(table->facet_index[f]);
+		g_ptr_array_unref(table->facets[f]);
+	}
+	g_hash_table_destroy(table->row_index);
+	g_free(table->pkgs);
+	g_free(table);
+}
+
+struct pkg_table_t *get_pkg_table(void)
+{
+	if (pkg_table == NULL) {
+		pkg_table = table_new(get_all_packages());
+	}
+
+	return pkg_table;
+}
+
+guint pkg_table_find_row(const struct pkg_table_t *table, alpm_pkg_t *pkg)
+{
+	gpointer row = g_hash_table_lookup(table->row_index, pkg);
+
+	return row == NULL ? PKG_TABLE_NO_ROW : GPOINTER_TO_UINT(row) - 1;
+}
+
+/* the rows of the installed packages in a set of local graph nodes */
+bitset_t *pkg_table_rows_from_nodes(const struct pkg_table_t *table, const bitset_t *nodes)
+{
+	bitset_t *rows = bitset_new(table->n_rows);
+	guint row;
+
+	for (row = 0; row < table->n_rows; row++) {
+		if (table->local_nodes[row] != DEP_GRAPH_NO_NODE && bitset_get(nodes, table->local_nodes[row])) {
+			bitset_set(rows, row);
+		}
+	}
+
+	return rows;
+}
+
+/* must be called before the database is released, the facet values belong to it */
+void pkg_table_free(void)
+{
+	g_clear_pointer(&pkg_table, table_free);
+}
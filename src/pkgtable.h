@@ -0,0 +1,93 @@
+/* pkgtable.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_PKGTABLE_H
+#define PF_PKGTABLE_H
+
+#include <alpm.h>
+#include <glib.h>
+#include <sys/types.h>
+
+#include "bitset.h"
+#include "database.h"
+#include "query.h"
+
+#define PKG_TABLE_NO_ROW G_MAXUINT
+
+typedef enum {
+	FACET_PACKAGER = 0,
+	FACET_LICENSE,
+	FACET_ARCH,
+	FACET_REPO,
+	FACET_GROUP,
+	NUM_FACETS
+} facet_t;
+
+typedef enum {
+	DATE_BUILD = 0,
+	DATE_INSTALL,
+	NUM_DATES
+} date_field_t;
+
+/* one value of a facet and the rows of every package having it */
+struct facet_value_t {
+	const gchar *value;
+	bitset_t *rows;
+};
+
+/* the all packages list numbered in order, with lookup structures for narrowing it
+ * down by package fields */
+struct pkg_table_t {
+	guint n_rows;
+	alpm_pkg_t **pkgs;
+	GHashTable *row_index;
+
+	/* facet values in name order, and the same values by name */
+	GPtrArray *facets[NUM_FACETS];
+	GHashTable *facet_index[NUM_FACETS];
+
+	/* ascending timestamps and the row each belongs to, packages without the
+	 * date (uninstalled ones for the install date) are left out */
+	guint n_dates[NUM_DATES];
+	gint64 *dates[NUM_DATES];
+	guint *date_rows[NUM_DATES];
+
+	/* per row columns scanned by search queries, text is lowercase */
+	off_t *sizes;
+	install_reason_t *statuses;
+	gchar **names;
+	gchar **descs;
+	gchar **packagers;
+
+	/* installed package node of each row, DEP_GRAPH_NO_NODE for the rest */
+	guint *local_nodes;
+	/* rows with a higher priority repository having the same package */
+	bitset_t *shadowed;
+};
+
+struct pkg_table_t *get_pkg_table(void);
+guint pkg_table_find_row(const struct pkg_table_t *table, alpm_pkg_t *pkg);
+bitset_t *pkg_table_rows_from_nodes(const struct pkg_table_t *table, const bitset_t *nodes);
+void pkg_table_free(void);
+
+/* pkgquery.c, lookups that only read the table and never call into libalpm */
+const struct facet_value_t *pkg_table_find_value(const struct pkg_table_t *table, const facet_t facet, const gchar *value);
+void pkg_table_add_date_range(const struct pkg_table_t *table, const date_field_t field, const gint64 from, const gint64 to, bitset_t *rows);
+void pkg_table_narrow_rows(const struct pkg_table_t *table, const struct query_t *query, bitset_t *result);
+bitset_t *pkg_table_run_query(const struct pkg_table_t *table, const struct query_t *query);
+
+#endif /* PF_PKGTABLE_H */
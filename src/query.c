@@ -0,0 +1,367 @@
+/* query.c - PacFinder search query parser
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "query.h"
+
+/* system libraries */
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <string.h>
+
+/* pacfinder */
+#include "database.h"
+#include "util.h"
+
+#define INSTALLED_MASK ((1 << PKG_REASON_EXPLICIT) | (1 << PKG_REASON_DEPEND) \
+                        | (1 << PKG_REASON_OPTIONAL) | (1 << PKG_REASON_ORPHAN))
+
+static const struct {
+	const gchar *name;
+	query_field_t field;
+} field_names[] = {
+	{ "name", QUERY_FIELD_NAME },
+	{ "desc", QUERY_FIELD_DESC },
+	{ "packager", QUERY_FIELD_PACKAGER },
+	{ "repo", QUERY_FIELD_REPO },
+	{ "group", QUERY_FIELD_GROUP },
+	{ "arch", QUERY_FIELD_ARCH },
+	{ "license", QUERY_FIELD_LICENSE },
+	{ "status", QUERY_FIELD_STATUS },
+	{ "size", QUERY_FIELD_SIZE },
+	{ "built", QUERY_FIELD_BUILT },
+	{ "installed", QUERY_FIELD_INSTALLED }
+};
+
+static const struct {
+	const gchar *name;
+	guint mask;
+} status_names[] = {
+	{ "installed", INSTALLED_MASK },
+	{ "uninstalled", 1 << PKG_REASON_NOT_INSTALLED },
+	{ "explicit", 1 << PKG_REASON_EXPLICIT },
+	{ "depend", 1 << PKG_REASON_DEPEND },
+	{ "optional", 1 << PKG_REASON_OPTIONAL },
+	{ "orphan", 1 << PKG_REASON_ORPHAN }
+};
+
+static const struct {
+	const gchar *name;
+	gint64 multiplier;
+} size_units[] = {
+	{ "", 1 },
+	{ "b", 1 },
+	{ "k", 1024 },
+	{ "kb", 1024 },
+	{ "kib", 1024 },
+	{ "m", 1024 * 1024 },
+	{ "mb", 1024 * 1024 },
+	{ "mib", 1024 * 1024 },
+	{ "g", 1024 * 1024 * 1024 },
+	{ "gb", 1024 * 1024 * 1024 },
+	{ "gib", 1024 * 1024 * 1024 }
+};
+
+G_DEFINE_QUARK(pacfinder-query-error-quark, query_error)
+
+static void term_free(struct query_term_t *term)
+{
+	g_free(term->text);
+	g_free(term);
+}
+
+/* a quoted value runs to the closing quote, anything else to the next space */
+static gchar *read_value(const gchar **pos, GError **error)
+{
+	const gchar *start = *pos;
+	const gchar *end;
+
+	if (*start != '"') {
+		for (end = start; *end != '\0' && !g_ascii_isspace(*end); end++);
+		*pos = end;
+		return g_strndup(start, end - start);
+	}
+
+	end = strchr(start + 1, '"');
+	if (end == NULL) {
+		/* l10n: search query error */
+		g_set_error(error, QUERY_ERROR, QUERY_ERROR_SYNTAX, _("Missing closing quote"));
+		return NULL;
+	}
+
+	*pos = end + 1;
+	return g_strndup(start + 1, end - start - 1);
+}
+
+/* "10M", "1.5GiB" or "300" bytes */
+static gboolean parse_size(const gchar *str, gint64 *size)
+{
+	gchar *end, *unit;
+	gdouble number;
+	gboolean found = FALSE;
+	guint i;
+
+	number = g_ascii_strtod(str, &end);
+	if (end == str || number < 0) {
+		return FALSE;
+	}
+
+	unit = g_ascii_strdown(end, -1);
+	for (i = 0; i < G_N_ELEMENTS(size_units); i++) {
+		if (g_strcmp0(unit, size_units[i].name) == 0) {
+			/* negated so that nan is turned away with anything too big for a gint64 */
+			if (!(number < (gdouble)G_MAXINT64 / size_units[i].multiplier)) {
+				break;
+			}
+			*size = number * size_units[i].multiplier;
+			found = TRUE;
+			break;
+		}
+	}
+	g_free(unit);
+
+	return found;
+}
+
+/* a date covers the whole year, month or day that was typed, comparisons are
+ * against the start or end of that period */
+static gboolean parse_date_range(const gchar *str, const query_cmp_t cmp, gint64 *from, gint64 *to)
+{
+	GDateTime *start, *end;
+	gint64 start_time, end_time;
+	const gchar *c;
+	guint parts = 1;
+
+	if (!parse_date(str, &start_time)) {
+		return FALSE;
+	}
+
+	for (c = str; *c != '\0'; c++) {
+		parts += *c == '-';
+	}
+
+	start = g_date_time_new_from_unix_local(start_time);
+	if (parts == 1) {
+		end = g_date_time_add_years(start, 1);
+	} else if (parts == 2) {
+		end = g_date_time_add_months(start, 1);
+	} else {
+		end = g_date_time_add_days(start, 1);
+	}
+	end_time = g_date_time_to_unix(end);
+	g_date_time_unref(start);
+	g_date_time_unref(end);
+
+	*from = G_MININT64;
+	*to = G_MAXINT64;
+
+	switch (cmp) {
+		case QUERY_CMP_EQ:
+			*from = start_time;
+			*to = end_time;
+			break;
+		case QUERY_CMP_LT:
+			*to = start_time;
+			break;
+		case QUERY_CMP_LE:
+			*to = end_time;
+			break;
+		case QUERY_CMP_GT:
+			*from = end_time;
+			break;
+		case QUERY_CMP_GE:
+			*from = start_time;
+			break;
+	}
+
+	return TRUE;
+}
+
+static gboolean set_field_term(struct query_term_t *term, const gchar *key, const query_cmp_t cmp,
+                               const gchar *value, GError **error)
+{
+	gboolean found = FALSE;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(field_names); i++) {
+		if (g_strcmp0(key, field_names[i].name) == 0) {
+			term->field = field_names[i].field;
+			found = TRUE;
+			break;
+		}
+	}
+	if (!found) {
+		/* l10n: search query error - %s is what was typed before the colon */
+		g_set_error(error, QUERY_ERROR, QUERY_ERROR_FIELD, _("Unknown field \"%s\""), key);
+		return FALSE;
+	}
+
+	term->cmp = cmp;
+
+	switch (term->field) {
+		case QUERY_FIELD_SIZE:
+			if (!parse_size(value, &term->size)) {
+				/* l10n: search query error - %s is the size that was typed */
+				g_set_error(error, QUERY_ERROR, QUERY_ERROR_VALUE, _("Invalid size \"%s\""), value);
+				return FALSE;
+			}
+			return TRUE;
+		case QUERY_FIELD_BUILT:
+		case QUERY_FIELD_INSTALLED:
+			if (!parse_date_range(value, cmp, &term->from, &term->to)) {
+				/* l10n: search query error - %s is the date that was typed */
+				g_set_error(error, QUERY_ERROR, QUERY_ERROR_VALUE, _("Invalid date \"%s\""), value);
+				return FALSE;
+			}
+			return TRUE;
+		default:
+			break;
+	}
+
+	/* everything else is matched, not ordered */
+	if (cmp != QUERY_CMP_EQ) {
+		/* l10n: search query error - %s is a field name like "repo" */
+		g_set_error(error, QUERY_ERROR, QUERY_ERROR_SYNTAX, _("\"%s\" can only be matched with a colon"), key);
+		return FALSE;
+	}
+
+	switch (term->field) {
+		case QUERY_FIELD_NAME:
+		case QUERY_FIELD_DESC:
+		case QUERY_FIELD_PACKAGER:
+			term->text = g_ascii_strdown(value, -1);
+			return TRUE;
+		case QUERY_FIELD_STATUS:
+			for (i = 0; i < G_N_ELEMENTS(status_names); i++) {
+				if (g_ascii_strcasecmp(value, status_names[i].name) == 0) {
+					term->status_mask = status_names[i].mask;
+					return TRUE;
+				}
+			}
+			/* l10n: search query error - %s is the status that was typed */
+			g_set_error(error, QUERY_ERROR, QUERY_ERROR_VALUE, _("Unknown status \"%s\""), value);
+			return FALSE;
+		default:
+			term->text = g_strdup(value);
+			return TRUE;
+	}
+}
+
+static query_cmp_t read_cmp(const gchar **pos)
+{
+	const gchar *c = *pos;
+
+	if (*c == ':' || *c == '=') {
+		*pos = c + 1;
+		return QUERY_CMP_EQ;
+	}
+
+	*pos = c + (c[1] == '=' ? 2 : 1);
+	if (*c == '<') {
+		return c[1] == '=' ? QUERY_CMP_LE : QUERY_CMP_LT;
+	}
+	return c[1] == '=' ? QUERY_CMP_GE : QUERY_CMP_GT;
+}
+
+/* whitespace separated terms that must all match. a term is a field, an operator
+ * (":", "=", "<", "<=", ">" or ">=") and a value, optionally quoted, or a bare word
+ * matching package names. a leading "-" negates a term */
+struct query_t *query_parse(const gchar *str, GError **error)
+{
+	struct query_t *query;
+	const gchar *pos = str;
+
+	g_return_val_if_fail(str != NULL, NULL);
+
+	query = g_new(struct query_t, 1);
+	query->terms = g_ptr_array_new_with_free_func((GDestroyNotify)term_free);
+
+	while (TRUE) {
+		struct query_term_t *term;
+		const gchar *key_end;
+		gchar *value;
+
+		while (g_ascii_isspace(*pos)) {
+			pos++;
+		}
+		if (*pos == '\0') {
+			break;
+		}
+
+		term = g_new0(struct query_term_t, 1);
+		g_ptr_array_add(query->terms, term);
+
+		if (*pos == '-' && pos[1] != '\0' && !g_ascii_isspace(pos[1])) {
+			term->negate = TRUE;
+			pos++;
+		}
+
+		for (key_end = pos; g_ascii_isalpha(*key_end); key_end++);
+
+		if (key_end > pos && *key_end != '\0' && strchr(":=<>", *key_end) != NULL) {
+			gchar *key = g_ascii_strdown(pos, key_end - pos);
+			query_cmp_t cmp;
+			gboolean valid;
+
+			pos = key_end;
+			cmp = read_cmp(&pos);
+			value = read_value(&pos, error);
+
+			if (value != NULL && *value == '\0') {
+				/* l10n: search query error - %s is a field name like "repo" */
+				g_set_error(error, QUERY_ERROR, QUERY_ERROR_SYNTAX, _("Missing value after \"%s\""), key);
+			}
+			valid = value != NULL && *value != '\0' && set_field_term(term, key, cmp, value, error);
+
+			g_free(key);
+			g_free(value);
+
+			if (!valid) {
+				query_free(query);
+				return NULL;
+			}
+		} else {
+			value = read_value(&pos, error);
+			if (value == NULL) {
+				query_free(query);
+				return NULL;
+			}
+
+			term->field = QUERY_FIELD_NAME;
+			term->text = g_ascii_strdown(value, -1);
+			g_free(value);
+		}
+	}
+
+	return query;
+}
+
+gboolean query_is_empty(const struct query_t *query)
+{
+	return query->terms->len == 0;
+}
+
+void query_free(struct query_t *query)
+{
+	if (query != NULL) {
+		g_ptr_array_unref(query->terms);
+		g_free(query);
+	}
+}
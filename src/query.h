@@ -0,0 +1,78 @@
+/* query.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_QUERY_H
+#define PF_QUERY_H
+
+#include <glib.h>
+
+#define QUERY_ERROR query_error_quark()
+
+typedef enum {
+	QUERY_ERROR_SYNTAX,
+	QUERY_ERROR_FIELD,
+	QUERY_ERROR_VALUE
+} query_error_t;
+
+typedef enum {
+	QUERY_FIELD_NAME = 0,
+	QUERY_FIELD_DESC,
+	QUERY_FIELD_PACKAGER,
+	QUERY_FIELD_REPO,
+	QUERY_FIELD_GROUP,
+	QUERY_FIELD_ARCH,
+	QUERY_FIELD_LICENSE,
+	QUERY_FIELD_STATUS,
+	QUERY_FIELD_SIZE,
+	QUERY_FIELD_BUILT,
+	QUERY_FIELD_INSTALLED
+} query_field_t;
+
+typedef enum {
+	QUERY_CMP_EQ = 0,
+	QUERY_CMP_LT,
+	QUERY_CMP_LE,
+	QUERY_CMP_GT,
+	QUERY_CMP_GE
+} query_cmp_t;
+
+struct query_term_t {
+	query_field_t field;
+	gboolean negate;
+	/* lowercase for the substring fields (name, desc, packager), as typed otherwise
+	 * and matched ignoring case */
+	gchar *text;
+	/* size: comparison against a size in bytes */
+	query_cmp_t cmp;
+	gint64 size;
+	/* dates: timestamps from, up to but not including, to */
+	gint64 from;
+	gint64 to;
+	/* status: one bit per install_reason_t value */
+	guint status_mask;
+};
+
+struct query_t {
+	GPtrArray *terms;
+};
+
+GQuark query_error_quark(void);
+struct query_t *query_parse(const gchar *str, GError **error);
+gboolean query_is_empty(const struct query_t *query);
+void query_free(struct query_t *query);
+
+#endif /* PF_QUERY_H */
@@ -0,0 +1,349 @@
+/* reportdialog.c - PacFinder heaviest packages report
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "reportdialog.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <gio/gio.h>
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+#include <sys/types.h>
+
+/* pacfinder */
+#include "database.h"
+#include "depgraph.h"
+#include "iconcache.h"
+#include "util.h"
+
+enum {
+	REPORT_COL_ICON = 0,
+	REPORT_COL_NAME,
+	REPORT_COL_EXCLUSIVE_SIZE,
+	REPORT_COL_EXCLUSIVE_COUNT,
+	REPORT_COL_TOTAL_SIZE,
+	REPORT_COL_TOTAL_COUNT,
+	REPORT_COL_PKG,
+	REPORT_NUM_COLS
+};
+
+struct report_row_t {
+	guint node;
+	guint exclusive_count;
+	off_t exclusive_size;
+	guint total_count;
+	off_t total_size;
+};
+
+/* rows are claimed one at a time by the worker threads */
+struct report_job_t {
+	struct dep_graph_t *graph;
+	GArray *rows;
+	gint next_row;
+};
+
+struct report_dialog_t {
+	GtkWidget *dialog;
+	GtkLabel *status_label;
+	GtkWidget *results;
+	GtkTreeView *treeview;
+	GtkListStore *store;
+	GCancellable *cancellable;
+	gboolean running;
+	report_activate_func on_activate;
+};
+
+static gpointer report_worker(gpointer data)
+{
+	struct report_job_t *job = data;
+	gint i;
+
+	while ((i = g_atomic_int_add(&job->next_row, 1)) < (gint)job->rows->len) {
+		struct report_row_t *row = &g_array_index(job->rows, struct report_row_t, i);
+		struct removal_t *removal;
+
+		dep_graph_get_closure_stats(job->graph, row->node, &row->total_count, &row->total_size);
+
+		removal = dep_graph_simulate_removal(job->graph, row->node, FALSE);
+		/* both counts leave out the package itself */
+		row->exclusive_count = removal->count - 1;
+		row->exclusive_size = removal->size;
+		removal_free(removal);
+	}
+
+	return NULL;
+}
+
+static void compute_report(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	struct report_job_t *job = task_data;
+	GThread **threads;
+	guint n_threads, i;
+
+	n_threads = CLAMP(g_get_num_processors(), 1, MAX(job->rows->len, 1));
+	threads = g_new(GThread *, n_threads);
+
+	for (i = 0; i < n_threads; i++) {
+		threads[i] = g_thread_new("pacfinder-report", report_worker, job);
+	}
+	for (i = 0; i < n_threads; i++) {
+		g_thread_join(threads[i]);
+	}
+
+	g_free(threads);
+	g_task_return_boolean(task, TRUE);
+}
+
+static void free_report_job(gpointer data)
+{
+	struct report_job_t *job = data;
+
+	dep_graph_unref(job->graph);
+	g_array_free(job->rows, TRUE);
+	g_free(job);
+}
+
+static void on_report_ready(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	struct report_dialog_t *report = user_data;
+	struct report_job_t *job = g_task_get_task_data(G_TASK(result));
+	guint i;
+
+	report->running = FALSE;
+
+	/* the dialog was closed while the report was running */
+	if (g_cancellable_is_cancelled(report->cancellable)) {
+		g_object_unref(report->cancellable);
+		g_free(report);
+		return;
+	}
+
+	for (i = 0; i < job->rows->len; i++) {
+		const struct report_row_t *row = &g_array_index(job->rows, struct report_row_t, i);
+		alpm_pkg_t *pkg = job->graph->pkgs[row->node];
+
+		gtk_list_store_insert_with_values(
+			report->store,
+			NULL,
+			-1,
+			REPORT_COL_ICON, get_status_icon_name(PKG_REASON_EXPLICIT),
+			REPORT_COL_NAME, alpm_pkg_get_name(pkg),
+			REPORT_COL_EXCLUSIVE_SIZE, (gint64)row->exclusive_size,
+			REPORT_COL_EXCLUSIVE_COUNT, row->exclusive_count,
+			REPORT_COL_TOTAL_SIZE, (gint64)row->total_size,
+			REPORT_COL_TOTAL_COUNT, row->total_count,
+			REPORT_COL_PKG, find_package(alpm_pkg_get_name(pkg)),
+			-1
+		);
+	}
+
+	gtk_tree_view_set_model(report->treeview, GTK_TREE_MODEL(report->store));
+	gtk_widget_hide(GTK_WIDGET(report->status_label));
+	gtk_widget_show(report->results);
+}
+
+static void start_report(struct report_dialog_t *report)
+{
+	struct report_job_t *job;
+	struct dep_graph_t *graph;
+	GTask *task;
+	guint v;
+
+	/* everything the workers read from libalpm or write to the graph is done here,
+	 * on the main thread, so the threads only read shared data */
+	graph = get_local_dep_graph();
+	dep_graph_compute_closures(graph);
+
+	job = g_new0(struct report_job_t, 1);
+	job->graph = dep_graph_ref(graph);
+	job->rows = g_array_new(FALSE, TRUE, sizeof(struct report_row_t));
+
+	for (v = 0; v < graph->n_nodes; v++) {
+		if (graph->reasons[v] == ALPM_PKG_REASON_EXPLICIT) {
+			struct report_row_t row = { .node = v };
+			g_array_append_val(job->rows, row);
+		}
+	}
+
+	report->running = TRUE;
+	task = g_task_new(NULL, NULL, on_report_ready, report);
+	g_task_set_task_data(task, job, free_report_job);
+	g_task_run_in_thread(task, compute_report);
+	g_object_unref(task);
+}
+
+static void size_cell_data_fn(GtkTreeViewColumn *column, GtkCellRenderer *renderer,
+                              GtkTreeModel *model, GtkTreeIter *iter, gpointer user_data)
+{
+	gint64 size;
+	gchar *size_str;
+
+	gtk_tree_model_get(model, iter, GPOINTER_TO_INT(user_data), &size, -1);
+	size_str = human_readable_size(size);
+	g_object_set(renderer, "text", size_str, NULL);
+	g_free(size_str);
+}
+
+static void on_report_row_activated(GtkTreeView *tree_view, GtkTreePath *path, GtkTreeViewColumn *column, gpointer user_data)
+{
+	struct report_dialog_t *report = user_data;
+	GtkTreeModel *model = gtk_tree_view_get_model(tree_view);
+	GtkTreeIter iter;
+	alpm_pkg_t *pkg;
+
+	if (report->on_activate != NULL && gtk_tree_model_get_iter(model, &iter, path)) {
+		gtk_tree_model_get(model, &iter, REPORT_COL_PKG, &pkg, -1);
+		if (pkg != NULL) {
+			report->on_activate(pkg);
+		}
+	}
+}
+
+static void on_report_destroy(GtkWidget *widget, gpointer user_data)
+{
+	struct report_dialog_t *report = user_data;
+
+	g_object_unref(report->store);
+
+	/* a running report frees this when it finishes */
+	if (report->running) {
+		g_cancellable_cancel(report->cancellable);
+	} else {
+		g_object_unref(report->cancellable);
+		g_free(report);
+	}
+}
+
+static void append_size_column(GtkTreeView *treeview, const gchar *title, const gint size_col)
+{
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(title, renderer, NULL);
+	gtk_tree_view_column_set_cell_data_func(column, renderer, size_cell_data_fn, GINT_TO_POINTER(size_col), NULL);
+	gtk_tree_view_column_set_sort_column_id(column, size_col);
+	gtk_tree_view_column_set_resizable(column, TRUE);
+	gtk_tree_view_append_column(treeview, column);
+}
+
+static void append_count_column(GtkTreeView *treeview, const gchar *title, const gint count_col)
+{
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(title, renderer, "text", count_col, NULL);
+	gtk_tree_view_column_set_sort_column_id(column, count_col);
+	gtk_tree_view_column_set_resizable(column, TRUE);
+	gtk_tree_view_append_column(treeview, column);
+}
+
+void show_report_dialog(GtkWindow *parent, report_activate_func on_activate)
+{
+	struct report_dialog_t *report;
+	GtkWidget *content_area, *scrolled_window, *box;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	report = g_new0(struct report_dialog_t, 1);
+	report->on_activate = on_activate;
+	report->cancellable = g_cancellable_new();
+
+	report->dialog = gtk_dialog_new_with_buttons(
+		/* l10n: heaviest packages report window title */
+		_("Heaviest Packages"),
+		parent,
+		GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT | GTK_DIALOG_USE_HEADER_BAR,
+		NULL,
+		NULL
+	);
+	gtk_window_set_default_size(GTK_WINDOW(report->dialog), 700, 500);
+
+	report->store = gtk_list_store_new(
+		REPORT_NUM_COLS,
+		G_TYPE_POINTER, /* status icon name */
+		G_TYPE_STRING,  /* name */
+		G_TYPE_INT64,   /* exclusive size */
+		G_TYPE_UINT,    /* exclusive count */
+		G_TYPE_INT64,   /* total size */
+		G_TYPE_UINT,    /* total count */
+		G_TYPE_POINTER  /* alpm_pkg_t */
+	);
+	gtk_tree_sortable_set_sort_column_id(
+		GTK_TREE_SORTABLE(report->store),
+		REPORT_COL_EXCLUSIVE_SIZE,
+		GTK_SORT_DESCENDING
+	);
+
+	report->treeview = GTK_TREE_VIEW(gtk_tree_view_new());
+
+	/* l10n: heaviest packages report column names */
+	column = gtk_tree_view_column_new();
+	gtk_tree_view_column_set_title(column, _("Package"));
+	renderer = gtk_cell_renderer_pixbuf_new();
+	gtk_tree_view_column_pack_start(column, renderer, FALSE);
+	gtk_cell_layout_set_cell_data_func(
+		GTK_CELL_LAYOUT(column),
+		renderer,
+		icon_cell_data_func,
+		GINT_TO_POINTER(REPORT_COL_ICON),
+		NULL
+	);
+	renderer = gtk_cell_renderer_text_new();
+	g_object_set(renderer, "weight", PANGO_WEIGHT_BOLD, NULL);
+	gtk_tree_view_column_pack_start(column, renderer, TRUE);
+	gtk_tree_view_column_add_attribute(column, renderer, "text", REPORT_COL_NAME);
+	gtk_tree_view_column_set_sort_column_id(column, REPORT_COL_NAME);
+	gtk_tree_view_column_set_expand(column, TRUE);
+	gtk_tree_view_column_set_resizable(column, TRUE);
+	gtk_tree_view_append_column(report->treeview, column);
+
+	append_size_column(report->treeview, _("Freed on Removal"), REPORT_COL_EXCLUSIVE_SIZE);
+	append_count_column(report->treeview, _("Removed Deps"), REPORT_COL_EXCLUSIVE_COUNT);
+	append_size_column(report->treeview, _("Total Size"), REPORT_COL_TOTAL_SIZE);
+	append_count_column(report->treeview, _("All Deps"), REPORT_COL_TOTAL_COUNT);
+
+	/* l10n: shown in the heaviest packages report while it is computed */
+	report->status_label = GTK_LABEL(gtk_label_new(_("Calculating package sizes…")));
+	gtk_widget_set_vexpand(GTK_WIDGET(report->status_label), TRUE);
+
+	scrolled_window = gtk_scrolled_window_new(NULL, NULL);
+	gtk_widget_set_vexpand(scrolled_window, TRUE);
+	gtk_container_add(GTK_CONTAINER(scrolled_window), GTK_WIDGET(report->treeview));
+	report->results = scrolled_window;
+
+	box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	gtk_container_add(GTK_CONTAINER(box), GTK_WIDGET(report->status_label));
+	gtk_container_add(GTK_CONTAINER(box), scrolled_window);
+
+	content_area = gtk_dialog_get_content_area(GTK_DIALOG(report->dialog));
+	gtk_box_pack_start(GTK_BOX(content_area), box, TRUE, TRUE, 0);
+
+	g_signal_connect(report->treeview, "row-activated", G_CALLBACK(on_report_row_activated), report);
+	g_signal_connect(report->dialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
+	g_signal_connect(report->dialog, "destroy", G_CALLBACK(on_report_destroy), report);
+
+	gtk_widget_show_all(report->dialog);
+	gtk_widget_hide(report->results);
+
+	start_report(report);
+}
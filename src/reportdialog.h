@@ -0,0 +1,28 @@
+/* reportdialog.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_REPORTDIALOG_H
+#define PF_REPORTDIALOG_H
+
+#include <alpm.h>
+#include <gtk/gtk.h>
+
+typedef void (*report_activate_func)(alpm_pkg_t *pkg);
+
+void show_report_dialog(GtkWindow *parent, report_activate_func on_activate);
+
+#endif /* PF_REPORTDIALOG_H */
@@ -0,0 +1,155 @@
+/* rowfilter.c - PacFinder package list visibility evaluation
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "rowfilter.h"
+
+/* system libraries */
+#include <glib.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+
+#define WORD_BITS 64
+/* words per thread below which more threads cost more than they save */
+#define MIN_ROW_FILTER_CHUNK 128
+
+/* one range of whole words, so no two threads ever write the same word */
+struct row_filter_job_t {
+	const struct row_filter_t *filter;
+	const install_reason_t *statuses;
+	bitset_t *result;
+	guint start;
+	guint end;
+};
+
+static gpointer evaluate_words(gpointer data)
+{
+	const struct row_filter_job_t *job = data;
+	const struct row_filter_t *filter = job->filter;
+	guint w, i;
+
+	for (w = job->start; w < job->end; w++) {
+		guint64 word = G_MAXUINT64;
+
+		/* rows past the end of the last word don't exist */
+		if (w == job->result->n_words - 1 && job->result->size % WORD_BITS != 0) {
+			word = ((guint64)1 << (job->result->size % WORD_BITS)) - 1;
+		}
+
+		for (i = 0; i < filter->n_required && word != 0; i++) {
+			word &= filter->required[i]->words[w];
+		}
+		for (i = 0; i < filter->n_excluded && word != 0; i++) {
+			word &= ~filter->excluded[i]->words[w];
+		}
+
+		/* the status is the only part checked row by row */
+		if (filter->hidden_statuses != 0) {
+			guint64 left = word;
+
+			while (left != 0) {
+				guint bit = __builtin_ctzll(left);
+
+				if (filter->hidden_statuses & (1 << job->statuses[w * WORD_BITS + bit])) {
+					word &= ~((guint64)1 << bit);
+				}
+				left &= left - 1;
+			}
+		}
+
+		job->result->words[w] = word;
+	}
+
+	return NULL;
+}
+
+void row_filter_init(struct row_filter_t *filter)
+{
+	filter->hidden_statuses = 0;
+	filter->match_none = FALSE;
+	filter->n_required = 0;
+	filter->n_excluded = 0;
+}
+
+/* a NULL set is one nothing has, like a repository without packages */
+void row_filter_require(struct row_filter_t *filter, const bitset_t *rows)
+{
+	if (rows == NULL) {
+		filter->match_none = TRUE;
+		return;
+	}
+
+	g_return_if_fail(filter->n_required < ROW_FILTER_MAX_SETS);
+	filter->required[filter->n_required++] = rows;
+}
+
+void row_filter_exclude(struct row_filter_t *filter, const bitset_t *rows)
+{
+	if (rows == NULL) {
+		return;
+	}
+
+	g_return_if_fail(filter->n_excluded < ROW_FILTER_MAX_SETS);
+	filter->excluded[filter->n_excluded++] = rows;
+}
+
+/* the visible rows, worked out in word ranges split across threads. the sets and
+ * statuses are only read, so they must not change until this returns */
+bitset_t *row_filter_evaluate(const struct row_filter_t *filter, const install_reason_t *statuses, const guint n_rows)
+{
+	struct row_filter_job_t *jobs;
+	GThread **threads;
+	bitset_t *result;
+	guint n_threads, chunk, i;
+
+	result = bitset_new(n_rows);
+	if (filter->match_none || n_rows == 0) {
+		return result;
+	}
+
+	n_threads = CLAMP(g_get_num_processors(), 1, MAX(result->n_words / MIN_ROW_FILTER_CHUNK, 1));
+	chunk = (result->n_words + n_threads - 1) / n_threads;
+	jobs = g_new(struct row_filter_job_t, n_threads);
+	threads = g_new(GThread *, n_threads);
+
+	for (i = 0; i < n_threads; i++) {
+		jobs[i].filter = filter;
+		jobs[i].statuses = statuses;
+		jobs[i].result = result;
+		jobs[i].start = MIN(i * chunk, result->n_words);
+		jobs[i].end = MIN(jobs[i].start + chunk, result->n_words);
+	}
+
+	/* the calling thread takes the first range itself */
+	for (i = 1; i < n_threads; i++) {
+		threads[i] = g_thread_new("pacfinder-filter", evaluate_words, &jobs[i]);
+	}
+	evaluate_words(&jobs[0]);
+	for (i = 1; i < n_threads; i++) {
+		g_thread_join(threads[i]);
+	}
+
+	g_free(threads);
+	g_free(jobs);
+
+	return result;
+}
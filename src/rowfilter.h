@@ -0,0 +1,46 @@
+/* rowfilter.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_ROWFILTER_H
+#define PF_ROWFILTER_H
+
+#include <glib.h>
+
+#include "bitset.h"
+#include "database.h"
+
+#define ROW_FILTER_MAX_SETS 8
+
+/* a package list filter over numbered rows: a row is visible when it is in every
+ * required set, in none of the excluded sets, and its status isn't hidden */
+struct row_filter_t {
+	/* one bit per install_reason_t value */
+	guint hidden_statuses;
+	/* a required set that was missing, nothing can match */
+	gboolean match_none;
+	const bitset_t *required[ROW_FILTER_MAX_SETS];
+	guint n_required;
+	const bitset_t *excluded[ROW_FILTER_MAX_SETS];
+	guint n_excluded;
+};
+
+void row_filter_init(struct row_filter_t *filter);
+void row_filter_require(struct row_filter_t *filter, const bitset_t *rows);
+void row_filter_exclude(struct row_filter_t *filter, const bitset_t *rows);
+bitset_t *row_filter_evaluate(const struct row_filter_t *filter, const install_reason_t *statuses, const guint n_rows);
+
+#endif /* PF_ROWFILTER_H */
@@ -112,6 +112,36 @@ void set_saved_right_height(gint height)
 	g_settings_set_int(settings, "right-height", height);
 }
 
+gboolean get_saved_merge_repo_duplicates(void)
+{
+	return g_settings_get_boolean(settings, "merge-repo-duplicates");
+}
+
+void set_saved_merge_repo_duplicates(const gboolean merge)
+{
+	g_settings_set_boolean(settings, "merge-repo-duplicates", merge);
+}
+
+gboolean get_saved_group_by_pkgbase(void)
+{
+	return g_settings_get_boolean(settings, "group-by-pkgbase");
+}
+
+void set_saved_group_by_pkgbase(const gboolean group)
+{
+	g_settings_set_boolean(settings, "group-by-pkgbase", group);
+}
+
+GVariant *get_saved_smart_filters(void)
+{
+	return g_settings_get_value(settings, "smart-filters");
+}
+
+void set_saved_smart_filters(GVariant *filters)
+{
+	g_settings_set_value(settings, "smart-filters", filters);
+}
+
 void get_saved_package_column_widths(gint *w1, gint *w2, gint *w3, gint *w4)
 {
 	g_settings_get(settings, "package-list-column-widths", "(iiii)", w1, w2, w3, w4);
@@ -30,6 +30,12 @@ gint get_saved_left_width(void);
 void set_saved_left_width(gint width);
 gint get_saved_right_height(void);
 void set_saved_right_height(gint height);
+gboolean get_saved_merge_repo_duplicates(void);
+void set_saved_merge_repo_duplicates(const gboolean merge);
+gboolean get_saved_group_by_pkgbase(void);
+void set_saved_group_by_pkgbase(const gboolean group);
+GVariant *get_saved_smart_filters(void);
+void set_saved_smart_filters(GVariant *filters);
 void get_saved_package_column_widths(gint *w1, gint *w2, gint *w3, gint *w4);
 void set_saved_package_column_widths(const gint w1, const gint w2, const gint w3, const gint w4);
 
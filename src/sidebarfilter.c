@@ -0,0 +1,97 @@
+/* sidebarfilter.c - PacFinder sidebar row filters as package table row sets
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "sidebarfilter.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "depgraph.h"
+#include "pkgtable.h"
+#include "rowfilter.h"
+
+/* adds what a sidebar row shows to the filter, for the package list and smart filters
+ * alike. status is the only per row check, everything else is a set of rows */
+void sidebar_filter_apply(struct row_filter_t *filter, struct sidebar_sets_t *sets, const guint status_filter,
+                          alpm_db_t *db, alpm_group_t *group)
+{
+	struct pkg_table_t *table = get_pkg_table();
+	const struct facet_value_t *value;
+
+	if (status_filter & HIDE_INSTALLED) {
+		filter->hidden_statuses |= (1 << PKG_REASON_EXPLICIT) | (1 << PKG_REASON_DEPEND)
+			| (1 << PKG_REASON_OPTIONAL) | (1 << PKG_REASON_ORPHAN);
+	}
+	if (status_filter & HIDE_UNINSTALLED) {
+		filter->hidden_statuses |= 1 << PKG_REASON_NOT_INSTALLED;
+	}
+	if (status_filter & HIDE_EXPLICIT) {
+		filter->hidden_statuses |= 1 << PKG_REASON_EXPLICIT;
+	}
+	if (status_filter & HIDE_DEPEND) {
+		filter->hidden_statuses |= 1 << PKG_REASON_DEPEND;
+	}
+	if (status_filter & HIDE_OPTION) {
+		filter->hidden_statuses |= 1 << PKG_REASON_OPTIONAL;
+	}
+	if (status_filter & HIDE_ORPHAN) {
+		filter->hidden_statuses |= 1 << PKG_REASON_ORPHAN;
+	}
+
+	value = pkg_table_find_value(table, FACET_REPO, "local");
+	if (status_filter & HIDE_NATIVE) {
+		row_filter_require(filter, value != NULL ? value->rows : NULL);
+	}
+	if (status_filter & HIDE_FOREIGN) {
+		row_filter_exclude(filter, value != NULL ? value->rows : NULL);
+	}
+
+	if (status_filter & HIDE_REACHABLE) {
+		sets->orphans = pkg_table_rows_from_nodes(table, dep_graph_get_recursive_orphans(get_local_dep_graph()));
+		row_filter_require(filter, sets->orphans);
+	}
+	if (status_filter & HIDE_INTACT) {
+		sets->broken = pkg_table_rows_from_nodes(table, dep_graph_get_broken(get_local_dep_graph()));
+		row_filter_require(filter, sets->broken);
+	}
+	if (status_filter & HIDE_UNSHADOWED) {
+		row_filter_require(filter, table->shadowed);
+	}
+
+	if (db != NULL) {
+		value = pkg_table_find_value(table, FACET_REPO, alpm_db_get_name(db));
+		row_filter_require(filter, value != NULL ? value->rows : NULL);
+	}
+	if (group != NULL) {
+		value = pkg_table_find_value(table, FACET_GROUP, group->name);
+		row_filter_require(filter, value != NULL ? value->rows : NULL);
+	}
+}
+
+void sidebar_sets_clear(struct sidebar_sets_t *sets)
+{
+	g_clear_pointer(&sets->orphans, bitset_free);
+	g_clear_pointer(&sets->broken, bitset_free);
+}
@@ -0,0 +1,57 @@
+/* sidebarfilter.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_SIDEBARFILTER_H
+#define PF_SIDEBARFILTER_H
+
+#include <alpm.h>
+#include <glib.h>
+
+#include "bitset.h"
+#include "rowfilter.h"
+
+/* package list filtering */
+enum {
+	HIDE_NONE = 0,
+	HIDE_INSTALLED = (1 << 0),
+	HIDE_UNINSTALLED = (1 << 1),
+	HIDE_EXPLICIT = (1 << 2),
+	HIDE_DEPEND = (1 << 3),
+	HIDE_OPTION = (1 << 4),
+	HIDE_ORPHAN = (1 << 5),
+	HIDE_NATIVE = (1 << 6),
+	HIDE_FOREIGN = (1 << 7),
+	HIDE_REACHABLE = (1 << 8),
+	HIDE_INTACT = (1 << 9),
+	HIDE_UNSHADOWED = (1 << 10)
+};
+
+/* the flags that only look at a package's install status */
+#define HIDE_STATUS_MASK (HIDE_INSTALLED | HIDE_UNINSTALLED | HIDE_EXPLICIT | HIDE_DEPEND \
+                          | HIDE_OPTION | HIDE_ORPHAN)
+
+/* row sets a sidebar filter had to build, kept until the row filter is evaluated */
+struct sidebar_sets_t {
+	bitset_t *orphans;
+	bitset_t *broken;
+};
+
+void sidebar_filter_apply(struct row_filter_t *filter, struct sidebar_sets_t *sets, const guint status_filter,
+                          alpm_db_t *db, alpm_group_t *group);
+void sidebar_sets_clear(struct sidebar_sets_t *sets);
+
+#endif /* PF_SIDEBARFILTER_H */
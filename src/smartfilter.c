@@ -0,0 +1,348 @@
+/* smartfilter.c - PacFinder saved package list views
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "smartfilter.h"
+
+/* system libraries */
+#include <alpm.h>
+#include <glib.h>
+#include <string.h>
+
+/* pacfinder */
+#include "bitset.h"
+#include "database.h"
+#include "pkgtable.h"
+#include "query.h"
+#include "rowfilter.h"
+#include "settings.h"
+#include "sidebarfilter.h"
+
+/* a package of the table before a reload */
+struct carried_row_t {
+	gchar *fingerprint;
+	guint row;
+};
+
+static GPtrArray *smart_filters = NULL;
+/* packages of the previous table by repository and name, kept from detaching until
+ * the cached rows are carried over to the new table */
+static GHashTable *carried_rows = NULL;
+
+static struct smart_filter_t *smart_filter_new(const gchar *name, const guint status_filter, const gchar *db_name,
+                                               const gchar *group_name, const gchar *query)
+{
+	struct smart_filter_t *filter = g_new0(struct smart_filter_t, 1);
+
+	filter->name = g_strdup(name);
+	filter->status_filter = status_filter;
+	filter->db_name = g_strdup(db_name != NULL ? db_name : "");
+	filter->group_name = g_strdup(group_name != NULL ? group_name : "");
+	filter->query = g_strdup(query != NULL ? query : "");
+
+	return filter;
+}
+
+static void smart_filter_free(struct smart_filter_t *filter)
+{
+	g_free(filter->name);
+	g_free(filter->db_name);
+	g_free(filter->group_name);
+	g_free(filter->query);
+	g_clear_pointer(&filter->rows, bitset_free);
+	g_clear_pointer(&filter->old_rows, bitset_free);
+	g_free(filter);
+}
+
+static void carried_row_free(struct carried_row_t *carried)
+{
+	g_free(carried->fingerprint);
+	g_free(carried);
+}
+
+static void save_smart_filters(void)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a(susss)"));
+	for (i = 0; i < smart_filters->len; i++) {
+		const struct smart_filter_t *filter = g_ptr_array_index(smart_filters, i);
+
+		g_variant_builder_add(
+			&builder,
+			"(susss)",
+			filter->name,
+			filter->status_filter,
+			filter->db_name,
+			filter->group_name,
+			filter->query
+		);
+	}
+
+	set_saved_smart_filters(g_variant_builder_end(&builder));
+}
+
+/* repositories and groups are saved by name, a name that is gone resolves to NULL */
+static void resolve_names(struct smart_filter_t *filter)
+{
+	alpm_list_t *i;
+
+	filter->db = NULL;
+	filter->group = NULL;
+
+	for (i = alpm_get_syncdbs(get_alpm_handle()); i && *filter->db_name != '\0'; i = alpm_list_next(i)) {
+		if (g_strcmp0(alpm_db_get_name(i->data), filter->db_name) == 0) {
+			filter->db = i->data;
+			break;
+		}
+	}
+
+	if (filter->db != NULL && *filter->group_name != '\0') {
+		filter->group = alpm_db_get_group(filter->db, filter->group_name);
+	}
+}
+
+/* the rows out of the candidates, or every row when that is NULL, the filter
+ * matches. the query narrows the candidates first since it mostly works on whole
+ * sets, the sidebar part is then the same row filter the package list uses */
+static bitset_t *evaluate_rows(const struct smart_filter_t *filter, const struct pkg_table_t *table,
+                               const bitset_t *candidates)
+{
+	struct row_filter_t row_filter;
+	struct sidebar_sets_t sets = { NULL, NULL };
+	struct query_t *query;
+	bitset_t *query_rows, *rows;
+
+	/* a saved repository or group that is gone matches nothing */
+	if ((*filter->db_name != '\0' && filter->db == NULL) || (*filter->group_name != '\0' && filter->group == NULL)) {
+		return bitset_new(table->n_rows);
+	}
+
+	query = query_parse(filter->query, NULL);
+	if (query == NULL) {
+		/* only valid queries are saved, but the settings can be edited by hand */
+		return bitset_new(table->n_rows);
+	}
+
+	if (candidates != NULL) {
+		query_rows = bitset_copy(candidates);
+	} else {
+		query_rows = bitset_new(table->n_rows);
+		bitset_fill(query_rows);
+	}
+	pkg_table_narrow_rows(table, query, query_rows);
+	query_free(query);
+
+	row_filter_init(&row_filter);
+	row_filter_require(&row_filter, query_rows);
+	sidebar_filter_apply(&row_filter, &sets, filter->status_filter, filter->db, filter->group);
+	rows = row_filter_evaluate(&row_filter, table->statuses, table->n_rows);
+
+	sidebar_sets_clear(&sets);
+	bitset_free(query_rows);
+
+	return rows;
+}
+
+static gchar *row_key(alpm_pkg_t *pkg)
+{
+	return g_strconcat(alpm_db_get_name(alpm_pkg_get_db(pkg)), "/", alpm_pkg_get_name(pkg), NULL);
+}
+
+/* everything a sidebar filter or query can look at that changes between syncs
+ * without the package version changing */
+static gchar *row_fingerprint(const struct pkg_table_t *table, const guint row)
+{
+	alpm_pkg_t *pkg = table->pkgs[row];
+	alpm_pkg_t *local_pkg = alpm_db_get_pkg(get_local_db(), alpm_pkg_get_name(pkg));
+
+	return g_strdup_printf(
+		"%s %d %" G_GINT64_FORMAT " %d",
+		alpm_pkg_get_version(pkg),
+		table->statuses[row],
+		local_pkg != NULL ? (gint64)alpm_pkg_get_installdate(local_pkg) : 0,
+		is_pkg_shadowed(pkg)
+	);
+}
+
+GPtrArray *get_smart_filters(void)
+{
+	if (smart_filters == NULL) {
+		GVariant *saved;
+		GVariantIter iter;
+		const gchar *name, *db_name, *group_name, *query;
+		guint status_filter;
+
+		smart_filters = g_ptr_array_new_with_free_func((GDestroyNotify)smart_filter_free);
+
+		saved = get_saved_smart_filters();
+		g_variant_iter_init(&iter, saved);
+		while (g_variant_iter_loop(&iter, "(&su&s&s&s)", &name, &status_filter, &db_name, &group_name, &query)) {
+			g_ptr_array_add(smart_filters, smart_filter_new(name, status_filter, db_name, group_name, query));
+		}
+		g_variant_unref(saved);
+	}
+
+	return smart_filters;
+}
+
+struct smart_filter_t *smart_filter_add(const gchar *name, const guint status_filter, const gchar *db_name,
+                                        const gchar *group_name, const gchar *query)
+{
+	struct smart_filter_t *filter = smart_filter_new(name, status_filter, db_name, group_name, query);
+
+	g_ptr_array_add(get_smart_filters(), filter);
+	save_smart_filters();
+
+	return filter;
+}
+
+void smart_filter_remove(struct smart_filter_t *filter)
+{
+	g_ptr_array_remove(get_smart_filters(), filter);
+	save_smart_filters();
+}
+
+/* evaluated once per load, after that switching to the filter is a lookup */
+const bitset_t *smart_filter_get_rows(struct smart_filter_t *filter)
+{
+	if (filter->rows == NULL) {
+		resolve_names(filter);
+		filter->rows = evaluate_rows(filter, get_pkg_table(), NULL);
+	}
+
+	return filter->rows;
+}
+
+/* must be called before the package table and database are released. cached rows
+ * are set aside to be carried over by smart_filters_attach(), except for filters
+ * using a status flag from the mask, which depend on other packages and are
+ * evaluated again */
+void smart_filters_detach(const guint recompute_mask)
+{
+	struct pkg_table_t *table;
+	gboolean carry = FALSE;
+	guint i, row;
+
+	if (smart_filters == NULL) {
+		return;
+	}
+
+	for (i = 0; i < smart_filters->len; i++) {
+		struct smart_filter_t *filter = g_ptr_array_index(smart_filters, i);
+
+		filter->db = NULL;
+		filter->group = NULL;
+		g_clear_pointer(&filter->old_rows, bitset_free);
+
+		if (filter->rows != NULL && (filter->status_filter & recompute_mask) == 0) {
+			filter->old_rows = filter->rows;
+			filter->rows = NULL;
+			carry = TRUE;
+		} else {
+			g_clear_pointer(&filter->rows, bitset_free);
+		}
+	}
+
+	g_clear_pointer(&carried_rows, g_hash_table_destroy);
+	if (!carry) {
+		return;
+	}
+
+	table = get_pkg_table();
+	carried_rows = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)carried_row_free);
+	for (row = 0; row < table->n_rows; row++) {
+		struct carried_row_t *carried = g_new(struct carried_row_t, 1);
+
+		carried->fingerprint = row_fingerprint(table, row);
+		carried->row = row;
+		g_hash_table_insert(carried_rows, row_key(table->pkgs[row]), carried);
+	}
+}
+
+/* moves the rows set aside by smart_filters_detach() over to the reloaded package
+ * table, only evaluating the filters for packages that are new or changed */
+void smart_filters_attach(void)
+{
+	struct pkg_table_t *table;
+	bitset_t *changed;
+	guint *origins;
+	guint i, row;
+
+	if (carried_rows == NULL) {
+		return;
+	}
+
+	table = get_pkg_table();
+	origins = g_new(guint, table->n_rows);
+	changed = bitset_new(table->n_rows);
+
+	for (row = 0; row < table->n_rows; row++) {
+		gchar *key = row_key(table->pkgs[row]);
+		struct carried_row_t *carried = g_hash_table_lookup(carried_rows, key);
+		gchar *fingerprint = row_fingerprint(table, row);
+
+		if (carried != NULL && strcmp(carried->fingerprint, fingerprint) == 0) {
+			origins[row] = carried->row;
+		} else {
+			origins[row] = PKG_TABLE_NO_ROW;
+			bitset_set(changed, row);
+		}
+
+		g_free(fingerprint);
+		g_free(key);
+	}
+
+	for (i = 0; i < smart_filters->len; i++) {
+		struct smart_filter_t *filter = g_ptr_array_index(smart_filters, i);
+		bitset_t *rows;
+
+		if (filter->old_rows == NULL) {
+			continue;
+		}
+
+		resolve_names(filter);
+		filter->rows = bitset_new(table->n_rows);
+		for (row = 0; row < table->n_rows; row++) {
+			if (origins[row] != PKG_TABLE_NO_ROW && bitset_get(filter->old_rows, origins[row])) {
+				bitset_set(filter->rows, row);
+			}
+		}
+
+		rows = evaluate_rows(filter, table, changed);
+		bitset_union(filter->rows, rows);
+		bitset_free(rows);
+
+		g_clear_pointer(&filter->old_rows, bitset_free);
+	}
+
+	g_debug("smart filters: re-evaluated %u of %u packages", bitset_count(changed), table->n_rows);
+
+	bitset_free(changed);
+	g_free(origins);
+	g_clear_pointer(&carried_rows, g_hash_table_destroy);
+}
+
+void smart_filters_free(void)
+{
+	g_clear_pointer(&carried_rows, g_hash_table_destroy);
+	g_clear_pointer(&smart_filters, g_ptr_array_unref);
+}
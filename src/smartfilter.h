@@ -0,0 +1,54 @@
+/* smartfilter.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_SMARTFILTER_H
+#define PF_SMARTFILTER_H
+
+#include <alpm.h>
+#include <glib.h>
+
+#include "bitset.h"
+
+/* a saved sidebar filter and search query, shown as its own sidebar row */
+struct smart_filter_t {
+	gchar *name;
+	guint status_filter;
+	/* empty when the filter isn't limited to a repository or group */
+	gchar *db_name;
+	gchar *group_name;
+	gchar *query;
+
+	/* the names resolved against the loaded databases */
+	alpm_db_t *db;
+	alpm_group_t *group;
+
+	/* matching package table rows, NULL until first needed */
+	bitset_t *rows;
+	/* rows of the table before a reload, carried over where packages didn't change */
+	bitset_t *old_rows;
+};
+
+GPtrArray *get_smart_filters(void);
+struct smart_filter_t *smart_filter_add(const gchar *name, const guint status_filter, const gchar *db_name,
+                                        const gchar *group_name, const gchar *query);
+void smart_filter_remove(struct smart_filter_t *filter);
+const bitset_t *smart_filter_get_rows(struct smart_filter_t *filter);
+void smart_filters_detach(const guint recompute_mask);
+void smart_filters_attach(void);
+void smart_filters_free(void);
+
+#endif /* PF_SMARTFILTER_H */
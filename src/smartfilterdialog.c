@@ -0,0 +1,149 @@
+/* smartfilterdialog.c - PacFinder save smart filter dialog
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* build config */
+#include "config.h"
+
+/* file header */
+#include "smartfilterdialog.h"
+
+/* system libraries */
+#include <glib/gi18n.h>
+#include <gtk/gtk.h>
+
+/* pacfinder */
+#include "query.h"
+
+struct smart_filter_dialog_t {
+	GtkWidget *dialog;
+	GtkEntry *name_entry;
+	GtkEntry *query_entry;
+	smart_filter_save_func on_save;
+};
+
+static GtkWidget *create_field_label(const gchar *title)
+{
+	GtkWidget *label = gtk_label_new(title);
+
+	gtk_label_set_xalign(GTK_LABEL(label), 0);
+
+	return label;
+}
+
+/* saving needs a name and a query that parses */
+static void on_smart_filter_changed(GtkEditable *editable, gpointer user_data)
+{
+	struct smart_filter_dialog_t *save = user_data;
+	GtkStyleContext *context = gtk_widget_get_style_context(GTK_WIDGET(save->query_entry));
+	struct query_t *query;
+	GError *error = NULL;
+	gchar *name;
+	gboolean valid;
+
+	query = query_parse(gtk_entry_get_text(save->query_entry), &error);
+	if (query != NULL) {
+		gtk_style_context_remove_class(context, "error");
+		gtk_widget_set_tooltip_text(GTK_WIDGET(save->query_entry), NULL);
+		query_free(query);
+	} else {
+		gtk_style_context_add_class(context, "error");
+		gtk_widget_set_tooltip_text(GTK_WIDGET(save->query_entry), error->message);
+		g_error_free(error);
+	}
+
+	name = g_strstrip(g_strdup(gtk_entry_get_text(save->name_entry)));
+	valid = query != NULL && *name != '\0';
+	g_free(name);
+
+	gtk_dialog_set_response_sensitive(GTK_DIALOG(save->dialog), GTK_RESPONSE_ACCEPT, valid);
+}
+
+static void on_smart_filter_response(GtkDialog *dialog, gint response_id, gpointer user_data)
+{
+	struct smart_filter_dialog_t *save = user_data;
+
+	if (response_id == GTK_RESPONSE_ACCEPT) {
+		gchar *name = g_strstrip(g_strdup(gtk_entry_get_text(save->name_entry)));
+
+		save->on_save(name, gtk_entry_get_text(save->query_entry));
+		g_free(name);
+	}
+
+	gtk_widget_destroy(save->dialog);
+}
+
+static void on_smart_filter_destroy(GtkWidget *widget, gpointer user_data)
+{
+	g_free(user_data);
+}
+
+/* the sidebar part of the filter is whatever row is selected, only named here, the
+ * query starts out as the current search and can be edited */
+void show_smart_filter_dialog(GtkWindow *parent, const gchar *view_title, const gchar *query,
+                              smart_filter_save_func on_save)
+{
+	struct smart_filter_dialog_t *save;
+	GtkWidget *content_area;
+	GtkGrid *grid;
+
+	save = g_new0(struct smart_filter_dialog_t, 1);
+	save->on_save = on_save;
+
+	save->dialog = gtk_dialog_new_with_buttons(
+		/* l10n: save smart filter window title */
+		_("Save Smart Filter"),
+		parent,
+		GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT | GTK_DIALOG_USE_HEADER_BAR,
+		/* l10n: save smart filter buttons */
+		_("_Cancel"), GTK_RESPONSE_CANCEL,
+		_("_Save"), GTK_RESPONSE_ACCEPT,
+		NULL
+	);
+	gtk_dialog_set_default_response(GTK_DIALOG(save->dialog), GTK_RESPONSE_ACCEPT);
+
+	save->name_entry = GTK_ENTRY(gtk_entry_new());
+	gtk_entry_set_activates_default(save->name_entry, TRUE);
+	gtk_widget_set_hexpand(GTK_WIDGET(save->name_entry), TRUE);
+
+	save->query_entry = GTK_ENTRY(gtk_entry_new());
+	gtk_entry_set_text(save->query_entry, query);
+	gtk_entry_set_activates_default(save->query_entry, TRUE);
+
+	grid = GTK_GRID(gtk_grid_new());
+	gtk_grid_set_row_spacing(grid, 6);
+	gtk_grid_set_column_spacing(grid, 12);
+	g_object_set(grid, "margin", 12, NULL);
+
+	/* l10n: save smart filter field labels */
+	gtk_grid_attach(grid, create_field_label(_("Name")), 0, 0, 1, 1);
+	gtk_grid_attach(grid, GTK_WIDGET(save->name_entry), 1, 0, 1, 1);
+	gtk_grid_attach(grid, create_field_label(_("Show")), 0, 1, 1, 1);
+	gtk_grid_attach(grid, create_field_label(view_title), 1, 1, 1, 1);
+	gtk_grid_attach(grid, create_field_label(_("Search")), 0, 2, 1, 1);
+	gtk_grid_attach(grid, GTK_WIDGET(save->query_entry), 1, 2, 1, 1);
+
+	content_area = gtk_dialog_get_content_area(GTK_DIALOG(save->dialog));
+	gtk_box_pack_start(GTK_BOX(content_area), GTK_WIDGET(grid), TRUE, TRUE, 0);
+
+	g_signal_connect(save->name_entry, "changed", G_CALLBACK(on_smart_filter_changed), save);
+	g_signal_connect(save->query_entry, "changed", G_CALLBACK(on_smart_filter_changed), save);
+	g_signal_connect(save->dialog, "response", G_CALLBACK(on_smart_filter_response), save);
+	g_signal_connect(save->dialog, "destroy", G_CALLBACK(on_smart_filter_destroy), save);
+
+	on_smart_filter_changed(NULL, save);
+	gtk_widget_show_all(save->dialog);
+}
@@ -0,0 +1,28 @@
+/* smartfilterdialog.h
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PF_SMARTFILTERDIALOG_H
+#define PF_SMARTFILTERDIALOG_H
+
+#include <gtk/gtk.h>
+
+typedef void (*smart_filter_save_func)(const gchar *name, const gchar *query);
+
+void show_smart_filter_dialog(GtkWindow *parent, const gchar *view_title, const gchar *query,
+                              smart_filter_save_func on_save);
+
+#endif /* PF_SMARTFILTERDIALOG_H */
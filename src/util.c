@@ -25,6 +25,7 @@
 #include <alpm.h>
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <string.h>
 #include <sys/types.h>
 
 static GPtrArray *list_to_ptrarray(const alpm_list_t *list)
@@ -109,6 +110,83 @@ gchar *strtrunc_dep_desc(const gchar *str)
 	return name;
 }
 
+/* "2023", "2023-06" or "2023-06-15" as a unix timestamp of local midnight on that
+ * day, leaving out the month or day means the first one */
+gboolean parse_date(const gchar *str, gint64 *timestamp)
+{
+	static const guint64 min[] = { 1970, 1, 1 };
+	static const guint64 max[] = { 9999, 12, 31 };
+	guint64 values[] = { 0, 1, 1 };
+	gchar **parts;
+	GDateTime *date;
+	guint n, i;
+	gboolean valid = TRUE;
+
+	g_return_val_if_fail(str != NULL, FALSE);
+
+	parts = g_strsplit(str, "-", 0);
+	n = g_strv_length(parts);
+	if (n < 1 || n > 3) {
+		valid = FALSE;
+	}
+
+	for (i = 0; valid && i < n; i++) {
+		valid = g_ascii_string_to_unsigned(parts[i], 10, min[i], max[i], &values[i], NULL);
+	}
+
+	g_strfreev(parts);
+
+	if (!valid || !g_date_valid_dmy(values[2], values[1], values[0])) {
+		return FALSE;
+	}
+
+	date = g_date_time_new_local(values[0], values[1], values[2], 0, 0, 0);
+	*timestamp = g_date_time_to_unix(date);
+	g_date_time_unref(date);
+
+	return TRUE;
+}
+
+/* index of the first of the ascending times that isn't before the given time, n
+ * when all of them are */
+guint sorted_time_index(const gint64 *times, const guint n, const gint64 time)
+{
+	guint low = 0, high = n;
+
+	while (low < high) {
+		guint mid = low + (high - low) / 2;
+
+		if (times[mid] < time) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/* the file name ending in the given extension. another of the known extensions is
+ * swapped for it, any other name gets it appended */
+gchar *set_file_extension(const gchar *name, const gchar **known, const gchar *extension)
+{
+	const gchar *dot = strrchr(name, '.');
+	guint i;
+
+	if (dot != NULL && dot != name) {
+		if (g_ascii_strcasecmp(dot + 1, extension) == 0) {
+			return g_strdup(name);
+		}
+		for (i = 0; known[i] != NULL; i++) {
+			if (g_ascii_strcasecmp(dot + 1, known[i]) == 0) {
+				return g_strdup_printf("%.*s.%s", (gint)(dot - name), name, extension);
+			}
+		}
+	}
+
+	return g_strconcat(name, ".", extension, NULL);
+}
+
 int package_cmp(const void *p1, const void *p2) {
 	alpm_pkg_t *pkg1 = (alpm_pkg_t *)p1;
 	alpm_pkg_t *pkg2 = (alpm_pkg_t *)p2;
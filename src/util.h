@@ -26,6 +26,9 @@ gchar *list_to_string(const alpm_list_t *list);
 gchar *deplist_to_string(const alpm_list_t *list);
 gchar *human_readable_size(const off_t size);
 gchar *strtrunc_dep_desc(const gchar *str);
+gboolean parse_date(const gchar *str, gint64 *timestamp);
+guint sorted_time_index(const gint64 *times, const guint n, const gint64 time);
+gchar *set_file_extension(const gchar *name, const gchar **known, const gchar *extension);
 int package_cmp(const void *p1, const void *p2);
 int group_cmp(const void *p1, const void *p2);
 int group_cmp_find(const void *p1, const void *p2);
@@ -31,39 +31,101 @@
 
 /* pacfinder */
 #include "aboutdialog.h"
+#include "bitset.h"
 #include "database.h"
+#include "depgraph.h"
+#include "details.h"
+#include "export.h"
+#include "facetpanel.h"
+#include "history.h"
+#include "iconcache.h"
 #include "interface.h"
 #include "main.h"
+#include "pkgtable.h"
+#include "query.h"
+#include "reportdialog.h"
+#include "rowfilter.h"
 #include "settings.h"
+#include "sidebarfilter.h"
+#include "smartfilter.h"
+#include "smartfilterdialog.h"
 #include "util.h"
 
-/* package list filtering */
-enum {
-	HIDE_NONE = 0,
-	HIDE_INSTALLED = (1 << 0),
-	HIDE_UNINSTALLED = (1 << 1),
-	HIDE_EXPLICIT = (1 << 2),
-	HIDE_DEPEND = (1 << 3),
-	HIDE_OPTION = (1 << 4),
-	HIDE_ORPHAN = (1 << 5),
-	HIDE_NATIVE = (1 << 6),
-	HIDE_FOREIGN = (1 << 7)
-};
-
 /* package list filters */
 static struct {
 	guint status_filter;
 	alpm_db_t *db;
 	alpm_group_t *group;
-	gchar *search_string;
+	/* rows matching the search query, NULL when there is no query */
+	bitset_t *query_rows;
+	/* hide packages a higher priority repository has too */
+	gboolean merge_repos;
+	/* rows of the selected smart filter, standing in for the status, repository
+	 * and group checks */
+	const bitset_t *smart_rows;
 } package_filters;
 
+/* number of rows above and below the selected package to precompute details for */
+#define PREFETCH_DISTANCE 2
+/* delay before prefetching starts, so holding an arrow key doesn't prefetch every row */
+#define PREFETCH_DELAY_MS 150
+/* a refilter changing more than this fraction of the list rebuilds the view at once */
+#define BULK_REFILTER_DIVISOR 8
+
+/* reusable optional dependency rows */
+struct dep_row_t {
+	GtkWidget *button;
+	GtkWidget *image;
+	GtkWidget *name_label;
+	GtkWidget *desc_label;
+	alpm_pkg_t *pkg;
+	gchar *virtual_name;
+};
+
+struct dep_row_pool_t {
+	GtkGrid *grid;
+	GPtrArray *rows;
+};
+
 /* local variables */
+static struct dep_row_pool_t opts_rows;
+static struct dep_row_pool_t optsfor_rows;
+static GQueue prefetch_queue = G_QUEUE_INIT;
+static guint prefetch_source_id = 0;
+static alpm_pkg_t *shown_pkg = NULL;
+static gboolean dep_tree_stale = FALSE;
+static gboolean removal_stale = FALSE;
+static gboolean group_by_base = FALSE;
+static gboolean package_groups_filled = FALSE;
+static gboolean package_groups_filling = FALSE;
 static gulong repo_selchange_handler_id;
 static gulong pkg_selchange_handler_id;
 static gulong search_changed_handler_id;
+static GSimpleAction *remove_smart_filter_action = NULL;
+static GSimpleAction *merge_repos_action = NULL;
+static GSimpleAction *group_by_base_action = NULL;
+static GtkWidget *facet_panel_widget = NULL;
+static GSimpleAction *export_action = NULL;
+static GSimpleAction *export_graph_action = NULL;
+/* set while an export is running */
+static GCancellable *export_cancellable = NULL;
+/* gtk3 widgets don't own their gestures */
+static GtkGesture *navigation_gesture = NULL;
+/* package table rows passing the current filters, NULL until first evaluated */
+static bitset_t *visible_rows = NULL;
 
 static void show_package(alpm_pkg_t *pkg);
+static void update_visible_rows(void);
+static void refilter_packages(void);
+static void update_sidebar_counts(void);
+
+static GtkTreeModelFilter *get_package_model(void)
+{
+	if (group_by_base) {
+		return main_window_gui.package_group_model;
+	}
+	return main_window_gui.package_list_model;
+}
 
 static void show_package_list(GtkListStore *package_list_store)
 {
@@ -83,6 +145,8 @@ static void show_package_list(GtkListStore *package_list_store)
 			PACKAGES_COL_STATUS, get_pkg_status(pkg),
 			PACAKGES_COL_REPO, alpm_db_get_name(alpm_pkg_get_db(pkg)),
 			PACKAGES_COL_PKG, pkg,
+			/* the package table numbers the same list in the same order */
+			PACKAGES_COL_ROW, icount,
 			-1
 		);
 
@@ -96,263 +160,573 @@ static void show_package_list(GtkListStore *package_list_store)
 	}
 }
 
-static void show_package_overview(alpm_pkg_t *pkg)
+static void append_group_member_row(GtkTreeStore *store, GtkTreeIter *parent, alpm_pkg_t *pkg, const install_reason_t status)
 {
-	gchar *str;
-	alpm_list_t *dep_list;
-	size_t count;
+	gtk_tree_store_insert_with_values(
+		store, NULL, parent, -1,
+		PACKAGES_COL_NAME, alpm_pkg_get_name(pkg),
+		PACKAGES_COL_VERSION, alpm_pkg_get_version(pkg),
+		PACKAGES_COL_STATUS, status,
+		PACAKGES_COL_REPO, alpm_db_get_name(alpm_pkg_get_db(pkg)),
+		PACKAGES_COL_PKG, pkg,
+		PACKAGES_COL_ROW, pkg_table_find_row(get_pkg_table(), pkg),
+		-1
+	);
+}
 
-	/* set icon */
-	switch (get_pkg_status(pkg)) {
-		case PKG_REASON_EXPLICIT:
-			gtk_image_set_from_icon_name(
-				GTK_IMAGE(main_window_gui.details_overview.status_image),
-				"icon-explicit",
-				GTK_ICON_SIZE_DIALOG
-			);
-			break;
-		case PKG_REASON_DEPEND:
-			gtk_image_set_from_icon_name(
-				GTK_IMAGE(main_window_gui.details_overview.status_image),
-				"icon-depend",
-				GTK_ICON_SIZE_DIALOG
-			);
-			break;
-		case PKG_REASON_OPTIONAL:
-			gtk_image_set_from_icon_name(
-				GTK_IMAGE(main_window_gui.details_overview.status_image),
-				"icon-optional",
-				GTK_ICON_SIZE_DIALOG
-			);
-			break;
-		case PKG_REASON_ORPHAN:
-			gtk_image_set_from_icon_name(
-				GTK_IMAGE(main_window_gui.details_overview.status_image),
-				"icon-orphan",
-				GTK_ICON_SIZE_DIALOG
-			);
-			break;
-		case PKG_REASON_NOT_INSTALLED:
-			gtk_image_set_from_icon_name(
-				GTK_IMAGE(main_window_gui.details_overview.status_image),
-				"icon-uninstalled",
-				GTK_ICON_SIZE_DIALOG
-			);
-			break;
+/* one row per pkgbase with the total install size of its packages, leading with
+ * the package of the same name when there is one. member rows are only filled in
+ * on first expansion, since most groups are never opened */
+static void append_group_row(GtkTreeStore *store, struct dep_graph_t *graph, const gchar *base, GPtrArray *members)
+{
+	install_reason_t status = PKG_REASON_NOT_INSTALLED;
+	alpm_pkg_t *lead = NULL;
+	GtkTreeIter iter;
+	gchar *name, *size;
+	off_t total = 0;
+	guint count = 0, i;
+
+	for (i = 0; i < members->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(members, i);
+
+		/* copies in lower priority repositories aren't separate packages */
+		if (is_pkg_shadowed(pkg)) {
+			continue;
+		}
+
+		count++;
+		total += alpm_pkg_get_isize(pkg);
+		if (lead == NULL && g_strcmp0(alpm_pkg_get_name(pkg), base) == 0) {
+			lead = pkg;
+		}
+		if (status == PKG_REASON_NOT_INSTALLED) {
+			status = dep_graph_get_pkg_status(graph, pkg);
+		}
 	}
 
-	/* set labels */
-	str = g_strdup_printf(
-		"<span size=\"xx-large\">%s</span>\n"
-		"<i>version %s</i>",
-		alpm_pkg_get_name(pkg),
-		alpm_pkg_get_version(pkg)
+	if (lead == NULL) {
+		lead = g_ptr_array_index(members, 0);
+	}
+
+	size = human_readable_size(total);
+	name = g_strdup_printf(
+		/* l10n: package list row grouping split packages - %s is the pkgbase, %u the
+		 * number of packages and the last %s their total install size */
+		ngettext("%s (%u package, %s)", "%s (%u packages, %s)", count),
+		base,
+		count,
+		size
 	);
-	gtk_label_set_markup(main_window_gui.details_overview.heading_label, str);
-	g_free(str);
-
-	gtk_label_set_label(main_window_gui.details_overview.desc_label, alpm_pkg_get_desc(pkg));
-
-	str = g_strdup_printf("<a href=\"%s\">%s</a>", alpm_pkg_get_url(pkg), alpm_pkg_get_url(pkg));
-	gtk_label_set_markup(main_window_gui.details_overview.link_label, str);
-	g_free(str);
-
-	str = human_readable_size(alpm_pkg_get_isize(pkg));
-	gtk_label_set_label(main_window_gui.details_overview.left_label, str);
-	g_free(str);
-	gtk_label_set_label(main_window_gui.details_overview.middle_label, alpm_pkg_get_arch(pkg));
-	gtk_label_set_label(main_window_gui.details_overview.right_label, alpm_db_get_name(alpm_pkg_get_db(pkg)));
-
-	dep_list = alpm_pkg_compute_requiredby(pkg);
-	count = alpm_list_count(dep_list);
-	/* l10n: package dependency counts - %ld will be a number (zero or more) */
-	str = g_strdup_printf(ngettext("%ld package", "%ld packages", count), count);
-	gtk_label_set_markup(main_window_gui.details_overview.required_by_label, str);
-	g_free(str);
-	alpm_list_free_inner(dep_list, g_free);
-	alpm_list_free(dep_list);
-
-	dep_list = alpm_pkg_compute_optionalfor(pkg);
-	count = alpm_list_count(dep_list);
-	str = g_strdup_printf(ngettext("%ld package", "%ld packages", count), count);
-	gtk_label_set_markup(main_window_gui.details_overview.optional_for_label, str);
-	g_free(str);
-	alpm_list_free_inner(dep_list, g_free);
-	alpm_list_free(dep_list);
-
-	dep_list = alpm_pkg_get_depends(pkg);
-	count = alpm_list_count(dep_list);
-	str = g_strdup_printf(ngettext("%ld package", "%ld packages", count), count);
-	gtk_label_set_markup(main_window_gui.details_overview.dependencies_label, str);
-	g_free(str);
+
+	gtk_tree_store_insert_with_values(
+		store, &iter, NULL, -1,
+		PACKAGES_COL_NAME, name,
+		PACKAGES_COL_VERSION, alpm_pkg_get_version(lead),
+		PACKAGES_COL_STATUS, status,
+		PACAKGES_COL_REPO, alpm_db_get_name(alpm_pkg_get_db(lead)),
+		PACKAGES_COL_PKG, lead,
+		PACKAGES_COL_BASE, base,
+		-1
+	);
+	gtk_tree_store_insert_with_values(store, NULL, &iter, -1, PACKAGES_COL_PKG, NULL, -1);
+
+	g_free(name);
+	g_free(size);
 }
 
-static void on_deppkg_clicked(GtkButton* self, alpm_pkg_t *pkg)
+/* a pkgbase is only worth a group row when it builds differently named packages,
+ * not just the same package in several repositories */
+static gboolean has_split_packages(GPtrArray *members)
+{
+	const gchar *name = alpm_pkg_get_name(g_ptr_array_index(members, 0));
+	guint i;
+
+	for (i = 1; i < members->len; i++) {
+		if (g_strcmp0(alpm_pkg_get_name(g_ptr_array_index(members, i)), name) != 0) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* filling pumps the main loop, so the controls that would refill or refilter the
+ * half built store are off until it is done */
+static void set_group_fill_controls_enabled(const gboolean enabled)
+{
+	g_simple_action_set_enabled(group_by_base_action, enabled);
+	g_simple_action_set_enabled(merge_repos_action, enabled);
+	gtk_widget_set_sensitive(facet_panel_widget, enabled);
+}
+
+static void show_package_groups(GtkTreeStore *store)
+{
+	struct dep_graph_t *graph;
+	GPtrArray *bases;
+	guint i;
+
+	if (package_groups_filling) {
+		return;
+	}
+	package_groups_filling = TRUE;
+	set_group_fill_controls_enabled(FALSE);
+
+	graph = get_local_dep_graph();
+	bases = get_pkgbases();
+
+	for (i = 0; i < bases->len; i++) {
+		const gchar *base = g_ptr_array_index(bases, i);
+		GPtrArray *members = get_pkgbase_members(base);
+		guint j;
+
+		if (has_split_packages(members)) {
+			append_group_row(store, graph, base, members);
+		} else {
+			for (j = 0; j < members->len; j++) {
+				alpm_pkg_t *pkg = g_ptr_array_index(members, j);
+				append_group_member_row(store, NULL, pkg, dep_graph_get_pkg_status(graph, pkg));
+			}
+		}
+
+		/* keep gtk moving while we're working, same as the flat list */
+		if (i % 10 == 0) {
+			while (gtk_events_pending()) {
+				gtk_main_iteration();
+			}
+		}
+	}
+
+	package_groups_filled = TRUE;
+	package_groups_filling = FALSE;
+	set_group_fill_controls_enabled(TRUE);
+}
+
+static gboolean on_package_group_test_expand(GtkTreeView *tree_view, GtkTreeIter *iter, GtkTreePath *path, gpointer user_data)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(main_window_gui.package_group_store);
+	struct dep_graph_t *graph;
+	GtkTreeIter store_iter, child;
+	GPtrArray *members;
+	alpm_pkg_t *child_pkg;
+	gchar *base;
+	guint i;
+
+	if (gtk_tree_view_get_model(tree_view) != GTK_TREE_MODEL(main_window_gui.package_group_model)) {
+		return FALSE;
+	}
+
+	gtk_tree_model_filter_convert_iter_to_child_iter(main_window_gui.package_group_model, &store_iter, iter);
+	if (!gtk_tree_model_iter_children(model, &child, &store_iter)) {
+		return FALSE;
+	}
+
+	/* already expanded once */
+	gtk_tree_model_get(model, &child, PACKAGES_COL_PKG, &child_pkg, -1);
+	if (child_pkg != NULL) {
+		return FALSE;
+	}
+
+	gtk_tree_model_get(model, &store_iter, PACKAGES_COL_BASE, &base, -1);
+	graph = get_local_dep_graph();
+	members = get_pkgbase_members(base);
+
+	for (i = 0; members != NULL && i < members->len; i++) {
+		alpm_pkg_t *pkg = g_ptr_array_index(members, i);
+		append_group_member_row(main_window_gui.package_group_store, &store_iter, pkg, dep_graph_get_pkg_status(graph, pkg));
+	}
+	gtk_tree_store_remove(main_window_gui.package_group_store, &child);
+
+	g_free(base);
+
+	/* FALSE allows the expansion */
+	return FALSE;
+}
+
+/* chain of packages from an explicitly installed one down to a dependency */
+static void show_package_installed_by(const struct pkg_details_t *details)
 {
+	GtkWidget *label = GTK_WIDGET(main_window_gui.details_overview.installed_by_label);
+	struct dep_graph_t *graph;
+	GArray *path;
+	GString *chain;
+	gchar *markup;
+	guint node, i;
+
+	if (details->status == PKG_REASON_NOT_INSTALLED || details->status == PKG_REASON_EXPLICIT) {
+		gtk_widget_hide(label);
+		return;
+	}
+
+	graph = get_local_dep_graph();
+	node = dep_graph_find_local_node(graph, details->pkg);
+	if (node == DEP_GRAPH_NO_NODE) {
+		gtk_widget_hide(label);
+		return;
+	}
+
+	path = dep_graph_get_install_path(graph, node);
+	if (path == NULL) {
+		markup = g_markup_printf_escaped(
+			"<b>%s</b> %s",
+			/* l10n: package overview - leads a chain of packages like "firefox → gtk3 → atk" */
+			_("Pulled in by:"),
+			/* l10n: package overview - shown after "Pulled in by:" for recursive orphans */
+			_("no explicitly installed package")
+		);
+	} else {
+		chain = g_string_new(NULL);
+		for (i = 0; i < path->len; i++) {
+			guint v = g_array_index(path, guint, i);
+
+			if (i > 0) {
+				/* dashed arrow for links that are only optional dependencies */
+				g_string_append(chain, graph->install_parent_optional[v] ? " ⇢ " : " → ");
+			}
+			g_string_append(chain, alpm_pkg_get_name(graph->pkgs[v]));
+		}
+		markup = g_markup_printf_escaped("<b>%s</b> %s", _("Pulled in by:"), chain->str);
+		g_string_free(chain, TRUE);
+		g_array_free(path, TRUE);
+	}
+
+	gtk_label_set_markup(GTK_LABEL(label), markup);
+	gtk_widget_show(label);
+
+	g_free(markup);
+}
+
+static void show_package_overview(const struct pkg_details_t *details)
+{
+	/* set icon */
+	gtk_image_set_from_icon_name(
+		GTK_IMAGE(main_window_gui.details_overview.status_image),
+		get_status_icon_name(details->status),
+		GTK_ICON_SIZE_DIALOG
+	);
+
+	/* set labels */
+	gtk_label_set_markup(main_window_gui.details_overview.heading_label, details->heading);
+	gtk_label_set_label(main_window_gui.details_overview.desc_label, details->rows[DETAIL_ROW_DESC]);
+	gtk_label_set_markup(main_window_gui.details_overview.link_label, details->link);
+	gtk_label_set_label(main_window_gui.details_overview.left_label, details->rows[DETAIL_ROW_ISIZE]);
+	gtk_label_set_label(main_window_gui.details_overview.middle_label, details->rows[DETAIL_ROW_ARCH]);
+	gtk_label_set_label(main_window_gui.details_overview.right_label, details->repo);
+	gtk_label_set_markup(main_window_gui.details_overview.required_by_label, details->required_by_count);
+	gtk_label_set_markup(main_window_gui.details_overview.optional_for_label, details->optional_for_count);
+	gtk_label_set_markup(main_window_gui.details_overview.dependencies_label, details->depends_count);
+
+	show_package_installed_by(details);
+}
+
+static void update_history_buttons(void)
+{
+	gtk_widget_set_sensitive(main_window_gui.back_button, history_can_go_back());
+	gtk_widget_set_sensitive(main_window_gui.forward_button, history_can_go_forward());
+}
+
+static void navigate_to_package(alpm_pkg_t *pkg)
+{
+	if (pkg != NULL) {
+		history_push(pkg);
+		update_history_buttons();
+	}
+
+	show_package(pkg);
+}
+
+static void navigate_back(void)
+{
+	alpm_pkg_t *pkg = history_back();
+
 	if (pkg != NULL) {
 		show_package(pkg);
-		gtk_notebook_set_current_page(main_window_gui.details_notebook, 0);
+		update_history_buttons();
 	}
 }
 
-static GtkWidget *create_dep_button(alpm_pkg_t *pkg, const gchar *label)
+static void navigate_forward(void)
 {
-	gchar *name;
-	GtkWidget *button, *image;
+	alpm_pkg_t *pkg = history_forward();
 
-	name = strtrunc_dep_desc(label);
-	button = gtk_button_new_with_label(name);
+	if (pkg != NULL) {
+		show_package(pkg);
+		update_history_buttons();
+	}
+}
 
-	switch (get_pkg_status(pkg)) {
-		case PKG_REASON_EXPLICIT:
-			image = gtk_image_new_from_icon_name("icon-explicit", GTK_ICON_SIZE_BUTTON);
-			break;
-		case PKG_REASON_DEPEND:
-			image = gtk_image_new_from_icon_name("icon-depend", GTK_ICON_SIZE_BUTTON);
-			break;
-		case PKG_REASON_OPTIONAL:
-			image = gtk_image_new_from_icon_name("icon-optional", GTK_ICON_SIZE_BUTTON);
-			break;
-		case PKG_REASON_ORPHAN:
-			image = gtk_image_new_from_icon_name("icon-orphan", GTK_ICON_SIZE_BUTTON);
-			break;
-		case PKG_REASON_NOT_INSTALLED:
-		default:
-			image = gtk_image_new_from_icon_name("icon-uninstalled", GTK_ICON_SIZE_BUTTON);
+static void on_deppkg_clicked(GtkButton* self, alpm_pkg_t *pkg)
+{
+	if (pkg != NULL) {
+		navigate_to_package(pkg);
+		gtk_notebook_set_current_page(main_window_gui.details_notebook, 0);
 	}
+}
+
+static void on_provider_clicked(GtkButton *button, alpm_pkg_t *pkg)
+{
+	GtkWidget *popover = gtk_widget_get_ancestor(GTK_WIDGET(button), GTK_TYPE_POPOVER);
 
-	gtk_button_set_image(GTK_BUTTON(button), image);
-	gtk_button_set_always_show_image(GTK_BUTTON(button), TRUE);
+	/* navigating rebuilds the details pane the popover points at, so close it
+	 * while its relative_to widget is still around */
+	gtk_popover_popdown(GTK_POPOVER(popover));
+	on_deppkg_clicked(button, pkg);
+}
 
-	g_signal_connect(button, "clicked", G_CALLBACK(on_deppkg_clicked), pkg);
+static GtkWidget *create_provider_button(alpm_pkg_t *pkg, const install_reason_t status)
+{
+	GtkWidget *button, *box, *image, *name_label, *repo_label;
 
-	g_free(name);
+	name_label = gtk_label_new(alpm_pkg_get_name(pkg));
+	repo_label = gtk_label_new(alpm_db_get_name(alpm_pkg_get_db(pkg)));
+	gtk_style_context_add_class(gtk_widget_get_style_context(repo_label), "dim-label");
+
+	/* installed providers stand out from the rest */
+	if (status != PKG_REASON_NOT_INSTALLED) {
+		gchar *markup = g_markup_printf_escaped("<b>%s</b>", alpm_pkg_get_name(pkg));
+		gtk_label_set_markup(GTK_LABEL(name_label), markup);
+		g_free(markup);
+	}
+
+	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+	image = gtk_image_new_from_icon_name(get_status_icon_name(status), GTK_ICON_SIZE_BUTTON);
+	gtk_box_pack_start(GTK_BOX(box), image, FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(box), name_label, FALSE, FALSE, 0);
+	gtk_box_pack_end(GTK_BOX(box), repo_label, FALSE, FALSE, 0);
+
+	button = gtk_button_new();
+	gtk_button_set_relief(GTK_BUTTON(button), GTK_RELIEF_NONE);
+	gtk_container_add(GTK_CONTAINER(button), box);
+	g_signal_connect(button, "clicked", G_CALLBACK(on_provider_clicked), pkg);
 
 	return button;
 }
 
-static void show_package_deps(alpm_pkg_t *pkg)
+/* lists every package providing a virtual name, installed providers first */
+static void show_providers_popover(GtkWidget *relative_to, const GdkRectangle *rect, const gchar *name)
 {
-	alpm_list_t *i;
-	gint row;
+	GtkWidget *popover, *box, *heading;
+	GPtrArray *providers;
+	install_reason_t *statuses;
+	gchar *markup;
+	guint i, pass;
+
+	providers = find_providers(name);
+	statuses = g_new(install_reason_t, MAX(providers->len, 1));
+	for (i = 0; i < providers->len; i++) {
+		statuses[i] = get_pkg_status(g_ptr_array_index(providers, i));
+	}
 
-	/* empty the dependencies boxes of any previous children */
-	gtk_container_foreach(
-		GTK_CONTAINER(main_window_gui.package_details_deps_box),
-		(void *)gtk_widget_destroy,
-		NULL
-	);
-	gtk_container_foreach(
-		GTK_CONTAINER(main_window_gui.package_details_opts_grid),
-		(void *)gtk_widget_destroy,
-		NULL
-	);
+	box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	g_object_set(box, "margin", 5, NULL);
+
+	/* l10n: heading of the virtual package providers list - %s is the provided name (e.g. java-runtime) */
+	markup = g_markup_printf_escaped(_("<b>Providers of %s</b>"), name);
+	heading = gtk_label_new(NULL);
+	gtk_label_set_markup(GTK_LABEL(heading), markup);
+	gtk_widget_set_margin_bottom(heading, 5);
+	gtk_box_pack_start(GTK_BOX(box), heading, FALSE, FALSE, 0);
+	g_free(markup);
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < providers->len; i++) {
+			gboolean installed = statuses[i] != PKG_REASON_NOT_INSTALLED;
+
+			if (installed == (pass == 0)) {
+				gtk_box_pack_start(
+					GTK_BOX(box),
+					create_provider_button(g_ptr_array_index(providers, i), statuses[i]),
+					FALSE,
+					FALSE,
+					0
+				);
+			}
+		}
+	}
 
-	/* append required dependencies */
-	for (i = alpm_pkg_get_depends(pkg); i; i = alpm_list_next(i)) {
-		gchar *dep_str;
-		alpm_pkg_t *dep_pkg;
-		GtkWidget *button;
+	if (providers->len == 0) {
+		/* l10n: shown in the virtual package providers list when nothing provides the name */
+		gtk_box_pack_start(GTK_BOX(box), gtk_label_new(_("No known packages provide this.")), FALSE, FALSE, 0);
+	}
 
-		dep_str = alpm_dep_compute_string(i->data);
-		dep_pkg = find_satisfier(dep_str);
-		button = create_dep_button(dep_pkg, dep_str);
+	popover = gtk_popover_new(relative_to);
+	if (rect != NULL) {
+		gtk_popover_set_pointing_to(GTK_POPOVER(popover), rect);
+	}
+	gtk_container_add(GTK_CONTAINER(popover), box);
+	g_signal_connect(popover, "closed", G_CALLBACK(gtk_widget_destroy), NULL);
 
-		gtk_flow_box_insert(main_window_gui.package_details_deps_box, button, -1);
+	gtk_widget_show_all(box);
+	gtk_popover_popup(GTK_POPOVER(popover));
 
-		g_free(dep_str);
-	}
+	g_free(statuses);
+	g_ptr_array_unref(providers);
+}
 
-	/* append optional dependencies */
-	for (i = alpm_pkg_get_optdepends(pkg), row = 0; i; i = alpm_list_next(i), row++) {
-		const alpm_depend_t *dep_obj;
-		gchar *dep_str;
-		alpm_pkg_t *dep_pkg;
-		GtkWidget *button, *label;
+static void on_dep_item_activated(GtkIconView *icon_view, GtkTreePath *path, gpointer user_data)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	GdkRectangle rect;
+	alpm_pkg_t *pkg;
+	gchar *virtual_name;
 
-		dep_obj = i->data;
-		dep_str = alpm_dep_compute_string(dep_obj);
-		dep_pkg = find_satisfier(dep_str);
+	model = gtk_icon_view_get_model(icon_view);
 
-		button = create_dep_button(dep_pkg, dep_str);
-		gtk_widget_set_margin_start(button, 5);
-		gtk_widget_set_margin_top(button, 5);
-		gtk_widget_set_margin_bottom(button, 5);
+	if (model != NULL && gtk_tree_model_get_iter(model, &iter, path)) {
+		gtk_tree_model_get(model, &iter, DEPS_COL_PKG, &pkg, DEPS_COL_VIRTUAL, &virtual_name, -1);
 
-		label = gtk_label_new(dep_obj->desc);
-		gtk_widget_set_halign(label, GTK_ALIGN_START);
-		gtk_label_set_line_wrap(GTK_LABEL(label), TRUE);
-		gtk_label_set_xalign(GTK_LABEL(label), 0);
+		/* virtual names ask which provider to go to instead of picking one */
+		if (virtual_name != NULL && gtk_icon_view_get_cell_rect(icon_view, path, NULL, &rect)) {
+			show_providers_popover(GTK_WIDGET(icon_view), &rect, virtual_name);
+		} else {
+			on_deppkg_clicked(NULL, pkg);
+		}
 
-		gtk_grid_attach(main_window_gui.package_details_opts_grid, button, 0, row, 1, 1);
-		gtk_grid_attach(main_window_gui.package_details_opts_grid, label, 1, row, 1, 1);
+		g_free(virtual_name);
+	}
+}
 
-		g_free(dep_str);
+static void on_dep_row_clicked(GtkButton *button, struct dep_row_t *row)
+{
+	if (row->virtual_name != NULL) {
+		show_providers_popover(GTK_WIDGET(button), NULL, row->virtual_name);
+	} else {
+		on_deppkg_clicked(button, row->pkg);
 	}
+}
+
+static void free_dep_row(gpointer data)
+{
+	struct dep_row_t *row = data;
 
-	gtk_widget_show_all(GTK_WIDGET(main_window_gui.package_details_deps_box));
-	gtk_widget_show_all(GTK_WIDGET(main_window_gui.package_details_opts_grid));
+	g_free(row->virtual_name);
+	g_free(row);
 }
 
-static void show_package_depsfor(alpm_pkg_t *pkg)
+static struct dep_row_t *create_dep_row(struct dep_row_pool_t *pool, guint row_index)
 {
-	alpm_list_t *required_by, *optional_for, *i;
-	gint row;
+	struct dep_row_t *row;
+	GtkWidget *box;
 
-	/* empty the dependents boxes of any previous children */
-	gtk_container_foreach(
-		GTK_CONTAINER(main_window_gui.package_details_depsfor_box),
-		(void *)gtk_widget_destroy,
-		NULL
-	);
-	gtk_container_foreach(
-		GTK_CONTAINER(main_window_gui.package_details_optsfor_grid),
-		(void *)gtk_widget_destroy,
-		NULL
-	);
+	row = g_new0(struct dep_row_t, 1);
 
-	/* append required by dependents */
-	required_by = alpm_pkg_compute_requiredby(pkg);
-	for (i = required_by; i; i = alpm_list_next(i)) {
-		alpm_pkg_t *dep;
-		GtkWidget *button;
+	/* the button content is built here rather than through gtk_button_set_label() so that
+	 * rebinding only updates the label and image instead of rebuilding the button child */
+	row->image = gtk_image_new();
+	row->name_label = gtk_label_new(NULL);
+	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 4);
+	gtk_box_pack_start(GTK_BOX(box), row->image, FALSE, FALSE, 0);
+	gtk_box_pack_start(GTK_BOX(box), row->name_label, FALSE, FALSE, 0);
 
-		dep = find_package(i->data);
-		button = create_dep_button(dep, alpm_pkg_get_name(dep));
+	row->button = gtk_button_new();
+	gtk_container_add(GTK_CONTAINER(row->button), box);
+	gtk_widget_set_margin_start(row->button, 5);
+	gtk_widget_set_margin_top(row->button, 5);
+	gtk_widget_set_margin_bottom(row->button, 5);
+	g_signal_connect(row->button, "clicked", G_CALLBACK(on_dep_row_clicked), row);
+
+	row->desc_label = gtk_label_new(NULL);
+	gtk_widget_set_halign(row->desc_label, GTK_ALIGN_START);
+	gtk_label_set_line_wrap(GTK_LABEL(row->desc_label), TRUE);
+	gtk_label_set_xalign(GTK_LABEL(row->desc_label), 0);
+
+	gtk_grid_attach(pool->grid, row->button, 0, row_index, 1, 1);
+	gtk_grid_attach(pool->grid, row->desc_label, 1, row_index, 1, 1);
+
+	gtk_widget_show_all(row->button);
+
+	return row;
+}
+
+static void bind_dep_row(struct dep_row_pool_t *pool, guint row_index, const struct pkg_dep_t *dep)
+{
+	struct dep_row_t *row;
 
-		gtk_flow_box_insert(main_window_gui.package_details_depsfor_box, button, -1);
+	if (row_index < pool->rows->len) {
+		row = g_ptr_array_index(pool->rows, row_index);
+	} else {
+		row = create_dep_row(pool, row_index);
+		g_ptr_array_add(pool->rows, row);
 	}
-	alpm_list_free_inner(required_by, g_free);
-	alpm_list_free(required_by);
 
-	/* append optional for dependents */
-	optional_for = alpm_pkg_compute_optionalfor(pkg);
-	for (i = optional_for, row = 0; i; i = alpm_list_next(i), row++) {
-		alpm_pkg_t *dep;
-		alpm_depend_t *optdep;
-		GtkWidget *button, *label;
+	row->pkg = dep->pkg;
+	g_free(row->virtual_name);
+	row->virtual_name = g_strdup(dep->virtual_name);
+	gtk_label_set_text(GTK_LABEL(row->name_label), dep->name);
+	gtk_image_set_from_icon_name(GTK_IMAGE(row->image), get_status_icon_name(dep->status), GTK_ICON_SIZE_BUTTON);
+	gtk_label_set_text(GTK_LABEL(row->desc_label), dep->desc ? dep->desc : "");
 
-		dep = find_package(i->data);
-		optdep = find_pkg_optdep(pkg, dep);
+	gtk_widget_show(row->button);
+	gtk_widget_show(row->desc_label);
+}
 
-		button = create_dep_button(dep, alpm_pkg_get_name(dep));
-		gtk_widget_set_margin_start(button, 5);
-		gtk_widget_set_margin_top(button, 5);
-		gtk_widget_set_margin_bottom(button, 5);
+static void bind_dep_rows(struct dep_row_pool_t *pool, const GArray *deps)
+{
+	guint i;
 
-		label = gtk_label_new(optdep ? optdep->desc : NULL);
-		gtk_widget_set_halign(label, GTK_ALIGN_START);
-		gtk_label_set_line_wrap(GTK_LABEL(label), TRUE);
-		gtk_label_set_xalign(GTK_LABEL(label), 0);
+	if (pool->rows == NULL) {
+		pool->rows = g_ptr_array_new_with_free_func(free_dep_row);
+	}
 
-		gtk_grid_attach(main_window_gui.package_details_optsfor_grid, button, 0, row, 1, 1);
-		gtk_grid_attach(main_window_gui.package_details_optsfor_grid, label, 1, row, 1, 1);
+	for (i = 0; i < deps->len; i++) {
+		bind_dep_row(pool, i, &g_array_index(deps, struct pkg_dep_t, i));
 	}
-	alpm_list_free_inner(optional_for, g_free);
-	alpm_list_free(optional_for);
 
-	gtk_widget_show_all(GTK_WIDGET(main_window_gui.package_details_depsfor_box));
-	gtk_widget_show_all(GTK_WIDGET(main_window_gui.package_details_optsfor_grid));
+	/* rows that are not needed for this package are hidden and kept for the next one */
+	for (i = deps->len; i < pool->rows->len; i++) {
+		struct dep_row_t *row = g_ptr_array_index(pool->rows, i);
+
+		row->pkg = NULL;
+		g_clear_pointer(&row->virtual_name, g_free);
+		gtk_widget_hide(row->button);
+		gtk_widget_hide(row->desc_label);
+	}
+}
+
+static void fill_dep_items(GtkIconView *icon_view, GtkListStore *store, const GArray *deps)
+{
+	guint i;
+
+	/* detach the model while it is rebuilt so the view doesn't relayout on every row */
+	gtk_icon_view_set_model(icon_view, NULL);
+	gtk_list_store_clear(store);
+
+	for (i = 0; i < deps->len; i++) {
+		const struct pkg_dep_t *dep = &g_array_index(deps, struct pkg_dep_t, i);
+
+		gtk_list_store_insert_with_values(
+			store,
+			NULL,
+			-1,
+			DEPS_COL_ICON, get_status_icon_name(dep->status),
+			DEPS_COL_NAME, dep->name,
+			DEPS_COL_PKG, dep->pkg,
+			DEPS_COL_VIRTUAL, dep->virtual_name,
+			-1
+		);
+	}
+
+	gtk_icon_view_set_model(icon_view, GTK_TREE_MODEL(store));
+}
+
+static void show_package_deps(const struct pkg_details_t *details)
+{
+	fill_dep_items(
+		main_window_gui.package_details_deps_view,
+		main_window_gui.package_details_deps_store,
+		details->depends
+	);
+	bind_dep_rows(&opts_rows, details->optdepends);
+}
+
+static void show_package_depsfor(const struct pkg_details_t *details)
+{
+	fill_dep_items(
+		main_window_gui.package_details_depsfor_view,
+		main_window_gui.package_details_depsfor_store,
+		details->required_by
+	);
+	bind_dep_rows(&optsfor_rows, details->optional_for);
 }
 
 static void append_details_row(GtkTreeIter *iter, const gchar *name, const gchar *value)
@@ -367,116 +741,416 @@ static void append_details_row(GtkTreeIter *iter, const gchar *name, const gchar
 	);
 }
 
-static void show_package_details(alpm_pkg_t *pkg)
+static void show_package_details(const struct pkg_details_t *details)
 {
-	alpm_pkg_t *local_pkg;
-	gchar *licenses_str, *groups_str, *provides_str, *dependson_str, *optionals_str,
-	      *requiredby_str, *optionalfor_str, *conflicts_str, *replaces_str, *fsize_str, *isize_str,
-	      *bdate_str, *idate_str;
-	alpm_list_t *requiredby, *optionalfor;
-	GDateTime *bdate, *idate;
+	gchar * const *rows = details->rows;
 	GtkTreeIter iter;
 
-	/* grab local package, if it exists */
-	local_pkg = alpm_db_get_pkg(get_local_db(), alpm_pkg_get_name(pkg));
+	/* empty list from any previously selected package */
+	gtk_list_store_clear(main_window_gui.package_details_list_store);
+
+	/* add detail rows */
+	/* l10n: package details tab row labels */
+	append_details_row(&iter, _("Name:"), rows[DETAIL_ROW_NAME]);
+	append_details_row(&iter, _("Version:"), rows[DETAIL_ROW_VERSION]);
+	append_details_row(&iter, _("Repositories:"), rows[DETAIL_ROW_REPOSITORIES]);
+	append_details_row(&iter, _("Description:"), rows[DETAIL_ROW_DESC]);
+	append_details_row(&iter, _("Architecture:"), rows[DETAIL_ROW_ARCH]);
+	append_details_row(&iter, _("URL:"), rows[DETAIL_ROW_URL]);
+	append_details_row(&iter, _("Licenses:"), rows[DETAIL_ROW_LICENSES]);
+	append_details_row(&iter, _("Groups:"), rows[DETAIL_ROW_GROUPS]);
+	append_details_row(&iter, _("Provides:"), rows[DETAIL_ROW_PROVIDES]);
+	append_details_row(&iter, _("Depends On:"), rows[DETAIL_ROW_DEPENDS]);
+	append_details_row(&iter, _("Optional:"), rows[DETAIL_ROW_OPTIONALS]);
+	append_details_row(&iter, _("Required By:"), rows[DETAIL_ROW_REQUIREDBY]);
+	append_details_row(&iter, _("Optional For:"), rows[DETAIL_ROW_OPTIONALFOR]);
+	append_details_row(&iter, _("Conflicts:"), rows[DETAIL_ROW_CONFLICTS]);
+	append_details_row(&iter, _("Conflicted By:"), rows[DETAIL_ROW_CONFLICTEDBY]);
+	append_details_row(&iter, _("Replaces:"), rows[DETAIL_ROW_REPLACES]);
+	append_details_row(&iter, _("Replaced By:"), rows[DETAIL_ROW_REPLACEDBY]);
+	append_details_row(&iter, _("File Size:"), rows[DETAIL_ROW_FSIZE]);
+	append_details_row(&iter, _("Install Size:"), rows[DETAIL_ROW_ISIZE]);
+	append_details_row(&iter, _("Packager:"), rows[DETAIL_ROW_PACKAGER]);
+	append_details_row(&iter, _("Build Date:"), rows[DETAIL_ROW_BDATE]);
+	append_details_row(&iter, _("Install Date:"), rows[DETAIL_ROW_IDATE]);
+}
 
-	/* compute dependency lists */
-	requiredby = alpm_pkg_compute_requiredby(pkg);
-	optionalfor = alpm_pkg_compute_optionalfor(pkg);
+/* a row is a cycle back into the tree when its package already appears above it */
+static gboolean is_dep_tree_ancestor(GtkTreeModel *model, GtkTreeIter *parent, alpm_pkg_t *pkg)
+{
+	GtkTreeIter iter, next;
+	alpm_pkg_t *row_pkg;
 
-	/* gather dates */
-	bdate = g_date_time_new_from_unix_local(alpm_pkg_get_builddate(pkg));
-	if (local_pkg != NULL) {
-		idate = g_date_time_new_from_unix_local(alpm_pkg_get_installdate(local_pkg));
-	} else {
-		idate = NULL;
-	}
-
-	/* build display strings */
-	licenses_str = list_to_string(alpm_pkg_get_licenses(pkg));
-	groups_str = list_to_string(alpm_pkg_get_groups(pkg));
-	provides_str = deplist_to_string(alpm_pkg_get_provides(pkg));
-	dependson_str = deplist_to_string(alpm_pkg_get_depends(pkg));
-	optionals_str = deplist_to_string(alpm_pkg_get_optdepends(pkg));
-	requiredby_str = list_to_string(requiredby);
-	optionalfor_str = list_to_string(optionalfor);
-	conflicts_str = deplist_to_string(alpm_pkg_get_conflicts(pkg));
-	replaces_str = deplist_to_string(alpm_pkg_get_replaces(pkg));
-	fsize_str = human_readable_size(alpm_pkg_get_size(pkg));
-	isize_str = human_readable_size(alpm_pkg_get_isize(pkg));
-	bdate_str = g_date_time_format_iso8601(bdate);
-	if (idate != NULL) {
-		idate_str = g_date_time_format_iso8601(idate);
+	if (pkg == shown_pkg) {
+		return TRUE;
+	}
+	if (parent == NULL) {
+		return FALSE;
+	}
+
+	iter = *parent;
+	while (TRUE) {
+		gtk_tree_model_get(model, &iter, DEPTREE_COL_PKG, &row_pkg, -1);
+		if (row_pkg == pkg) {
+			return TRUE;
+		}
+		if (!gtk_tree_model_iter_parent(model, &next, &iter)) {
+			return FALSE;
+		}
+		iter = next;
+	}
+}
+
+static void append_dep_tree_row(struct dep_graph_t *graph, GtkTreeIter *parent, const guint node)
+{
+	GtkTreeStore *store = main_window_gui.package_tree_store;
+	alpm_pkg_t *pkg = graph->pkgs[node];
+	GtkTreeIter iter, placeholder;
+	gboolean cycle;
+	gchar *name, *size;
+	guint count;
+	off_t total;
+
+	cycle = is_dep_tree_ancestor(GTK_TREE_MODEL(store), parent, pkg);
+	dep_graph_get_closure_stats(graph, node, &count, &total);
+
+	if (cycle) {
+		/* l10n: dependency tree row for a package that depends back on one above it - %s is package name */
+		name = g_strdup_printf(_("%s (circular)"), alpm_pkg_get_name(pkg));
 	} else {
-		idate_str = "";
+		name = g_strdup(alpm_pkg_get_name(pkg));
 	}
+	size = human_readable_size(total);
+
+	gtk_tree_store_insert_with_values(
+		store, &iter, parent, -1,
+		DEPTREE_COL_ICON, get_status_icon_name(get_pkg_status(pkg)),
+		DEPTREE_COL_NAME, name,
+		DEPTREE_COL_SIZE, size,
+		DEPTREE_COL_PKG, pkg,
+		-1
+	);
 
-	/* clean up dates */
-	g_date_time_unref(bdate);
-	if (idate != NULL) g_date_time_unref(idate);
+	/* children are filled in on first expansion, the empty row only makes it expandable */
+	if (!cycle && graph->edge_offsets[node] < graph->edge_offsets[node + 1]) {
+		gtk_tree_store_insert_with_values(store, &placeholder, &iter, -1, DEPTREE_COL_PKG, NULL, -1);
+	}
 
-	/* clean up dependency lists */
-	alpm_list_free_inner(requiredby, g_free);
-	alpm_list_free_inner(optionalfor, g_free);
-	alpm_list_free(requiredby);
-	alpm_list_free(optionalfor);
+	g_free(name);
+	g_free(size);
+}
 
-	/* empty list from any previously selected package */
-	gtk_list_store_clear(main_window_gui.package_details_list_store);
+static void append_dep_tree_children(struct dep_graph_t *graph, GtkTreeIter *parent, const guint node)
+{
+	guint e;
 
-	/* add detail rows */
-	/* l10n: package details tab row labels */
-	append_details_row(&iter, _("Name:"), alpm_pkg_get_name(pkg));
-	append_details_row(&iter, _("Version:"), alpm_pkg_get_version(pkg));
-	append_details_row(&iter, _("Description:"), alpm_pkg_get_desc(pkg));
-	append_details_row(&iter, _("Architecture:"), alpm_pkg_get_arch(pkg));
-	append_details_row(&iter, _("URL:"), alpm_pkg_get_url(pkg));
-	append_details_row(&iter, _("Licenses:"), licenses_str);
-	append_details_row(&iter, _("Groups:"), groups_str);
-	append_details_row(&iter, _("Provides:"), provides_str);
-	append_details_row(&iter, _("Depends On:"), dependson_str);
-	append_details_row(&iter, _("Optional:"), optionals_str);
-	append_details_row(&iter, _("Required By:"), requiredby_str);
-	append_details_row(&iter, _("Optional For:"), optionalfor_str);
-	append_details_row(&iter, _("Conflicts:"), conflicts_str);
-	append_details_row(&iter, _("Replaces:"), replaces_str);
-	append_details_row(&iter, _("File Size:"), fsize_str);
-	append_details_row(&iter, _("Install Size:"), isize_str);
-	append_details_row(&iter, _("Packager:"), alpm_pkg_get_packager(pkg));
-	append_details_row(&iter, _("Build Date:"), bdate_str);
-	append_details_row(&iter, _("Install Date:"), idate_str);
-
-	/* clean up display strings */
-	g_free(licenses_str);
-	g_free(groups_str);
-	g_free(provides_str);
-	g_free(dependson_str);
-	g_free(optionals_str);
-	g_free(requiredby_str);
-	g_free(optionalfor_str);
-	g_free(conflicts_str);
-	g_free(replaces_str);
-	g_free(fsize_str);
-	g_free(isize_str);
-	g_free(bdate_str);
-	if (idate != NULL) g_free(idate_str);
+	for (e = graph->edge_offsets[node]; e < graph->edge_offsets[node + 1]; e++) {
+		append_dep_tree_row(graph, parent, graph->edges[e]);
+	}
+}
+
+static gboolean on_dep_tree_test_expand(GtkTreeView *tree_view, GtkTreeIter *iter, GtkTreePath *path, gpointer user_data)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(main_window_gui.package_tree_store);
+	struct dep_graph_t *graph;
+	GtkTreeIter child;
+	alpm_pkg_t *pkg, *child_pkg;
+	guint node;
+
+	if (!gtk_tree_model_iter_children(model, &child, iter)) {
+		return FALSE;
+	}
+
+	/* already expanded once */
+	gtk_tree_model_get(model, &child, DEPTREE_COL_PKG, &child_pkg, -1);
+	if (child_pkg != NULL) {
+		return FALSE;
+	}
+
+	gtk_tree_model_get(model, iter, DEPTREE_COL_PKG, &pkg, -1);
+	graph = get_dep_graph();
+	node = dep_graph_find_node(graph, pkg);
+
+	if (node != DEP_GRAPH_NO_NODE) {
+		append_dep_tree_children(graph, iter, node);
+	}
+	gtk_tree_store_remove(main_window_gui.package_tree_store, &child);
+
+	/* FALSE allows the expansion */
+	return FALSE;
+}
+
+static void on_dep_tree_row_activated(GtkTreeView *tree_view, GtkTreePath *path, GtkTreeViewColumn *column, gpointer user_data)
+{
+	GtkTreeModel *model = gtk_tree_view_get_model(tree_view);
+	GtkTreeIter iter;
+	alpm_pkg_t *pkg;
+
+	if (gtk_tree_model_get_iter(model, &iter, path)) {
+		gtk_tree_model_get(model, &iter, DEPTREE_COL_PKG, &pkg, -1);
+		on_deppkg_clicked(NULL, pkg);
+	}
+}
+
+static void show_package_dep_tree(void)
+{
+	struct dep_graph_t *graph;
+	gchar *summary, *size;
+	guint node, count;
+	off_t total;
+
+	dep_tree_stale = FALSE;
+	gtk_tree_store_clear(main_window_gui.package_tree_store);
+	gtk_label_set_text(main_window_gui.package_tree_summary_label, "");
+
+	if (shown_pkg == NULL) {
+		return;
+	}
+
+	graph = get_dep_graph();
+	node = dep_graph_find_node(graph, shown_pkg);
+	if (node == DEP_GRAPH_NO_NODE) {
+		return;
+	}
+
+	dep_graph_get_closure_stats(graph, node, &count, &total);
+	size = human_readable_size(total);
+	summary = g_strdup_printf(
+		/* l10n: dependency tree summary - %u is number of packages, %s is a size like "12.5 MiB" */
+		ngettext(
+			"Depends on %u package in total, %s installed size including this package",
+			"Depends on %u packages in total, %s installed size including this package",
+			count
+		),
+		count,
+		size
+	);
+	gtk_label_set_text(main_window_gui.package_tree_summary_label, summary);
+
+	append_dep_tree_children(graph, NULL, node);
+
+	g_free(summary);
+	g_free(size);
+}
+
+static void fill_graph_items(GtkIconView *icon_view, GtkListStore *store, const struct dep_graph_t *graph, const GArray *nodes)
+{
+	guint i;
+
+	gtk_icon_view_set_model(icon_view, NULL);
+	gtk_list_store_clear(store);
+
+	for (i = 0; i < nodes->len; i++) {
+		guint node = g_array_index(nodes, guint, i);
+		const gchar *name = alpm_pkg_get_name(graph->pkgs[node]);
+
+		gtk_list_store_insert_with_values(
+			store,
+			NULL,
+			-1,
+			DEPS_COL_ICON, get_status_icon_name(dep_graph_get_status(graph, node)),
+			DEPS_COL_NAME, name,
+			DEPS_COL_PKG, find_package(name),
+			-1
+		);
+	}
+
+	gtk_icon_view_set_model(icon_view, GTK_TREE_MODEL(store));
+}
+
+static void show_package_removal(void)
+{
+	struct dep_graph_t *graph;
+	struct removal_t *removal;
+	GArray *removed;
+	gchar *size, *removes, *breaks, *summary;
+	guint node, bit;
+
+	removal_stale = FALSE;
+	gtk_list_store_clear(main_window_gui.package_removal_store);
+	gtk_list_store_clear(main_window_gui.package_removal_broken_store);
+	gtk_label_set_text(main_window_gui.package_removal_summary_label, "");
+
+	if (shown_pkg == NULL) {
+		return;
+	}
+
+	graph = get_local_dep_graph();
+	node = dep_graph_find_local_node(graph, shown_pkg);
+	if (node == DEP_GRAPH_NO_NODE) {
+		/* l10n: package removal tab text for packages that are not installed */
+		gtk_label_set_text(main_window_gui.package_removal_summary_label, _("This package is not installed."));
+		return;
+	}
+
+	removal = dep_graph_simulate_removal(graph, node, TRUE);
+
+	removed = g_array_sized_new(FALSE, FALSE, sizeof(guint), removal->count);
+	for (bit = 0; bitset_next(removal->removed, &bit); bit++) {
+		g_array_append_val(removed, bit);
+	}
+	fill_graph_items(main_window_gui.package_removal_view, main_window_gui.package_removal_store, graph, removed);
+	fill_graph_items(main_window_gui.package_removal_broken_view, main_window_gui.package_removal_broken_store, graph, removal->broken);
+
+	size = human_readable_size(removal->size);
+	removes = g_strdup_printf(
+		/* l10n: package removal summary - %u is number of packages, %s is a size like "12.5 MiB" */
+		ngettext(
+			"Removing this package with pacman -Rs removes %u package and frees %s.",
+			"Removing this package with pacman -Rs removes %u packages and frees %s.",
+			removal->count
+		),
+		removal->count,
+		size
+	);
+
+	if (removal->broken->len > 0) {
+		breaks = g_strdup_printf(
+			/* l10n: package removal warning - %u is number of installed packages */
+			ngettext(
+				"%u installed package would be left with a missing dependency, so pacman would refuse the removal.",
+				"%u installed packages would be left with a missing dependency, so pacman would refuse the removal.",
+				removal->broken->len
+			),
+			removal->broken->len
+		);
+		summary = g_strjoin(" ", removes, breaks, NULL);
+		g_free(breaks);
+	} else {
+		summary = g_strdup(removes);
+	}
+	gtk_label_set_text(main_window_gui.package_removal_summary_label, summary);
+
+	g_free(summary);
+	g_free(removes);
+	g_free(size);
+	g_array_free(removed, TRUE);
+	removal_free(removal);
+}
+
+/* tabs that walk the dependency graphs are only built while they are showing */
+static void show_graph_page(GtkWidget *page)
+{
+	if (page == main_window_gui.package_tree_page && dep_tree_stale) {
+		show_package_dep_tree();
+	} else if (page == main_window_gui.package_removal_page && removal_stale) {
+		show_package_removal();
+	}
+}
+
+static void on_details_page_switch(GtkNotebook *notebook, GtkWidget *page, guint page_num, gpointer user_data)
+{
+	show_graph_page(page);
 }
 
 static void show_package(alpm_pkg_t *pkg)
 {
+	struct pkg_details_t *details;
+
+	shown_pkg = pkg;
+
 	if (pkg == NULL) {
+		show_package_dep_tree();
+		show_package_removal();
 		gtk_widget_hide(GTK_WIDGET(main_window_gui.details_notebook));
 		return;
 	}
 
-	show_package_overview(pkg);
-	show_package_deps(pkg);
-	show_package_depsfor(pkg);
-	show_package_details(pkg);
+	/* recently viewed packages come straight out of the details cache */
+	details = get_pkg_details(pkg);
+
+	show_package_overview(details);
+	show_package_deps(details);
+	show_package_depsfor(details);
+	show_package_details(details);
+
+	dep_tree_stale = TRUE;
+	removal_stale = TRUE;
+	show_graph_page(gtk_notebook_get_nth_page(
+		main_window_gui.details_notebook,
+		gtk_notebook_get_current_page(main_window_gui.details_notebook)
+	));
 
 	gtk_widget_show(GTK_WIDGET(main_window_gui.details_notebook));
 }
 
+static void cancel_prefetch(void)
+{
+	if (prefetch_source_id != 0) {
+		g_source_remove(prefetch_source_id);
+		prefetch_source_id = 0;
+	}
+	g_queue_clear(&prefetch_queue);
+}
+
+static gboolean prefetch_next(gpointer user_data)
+{
+	alpm_pkg_t *pkg;
+
+	/* back off while the main loop has user input or drawing to deal with */
+	if (gtk_events_pending()) {
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* one package per iteration to keep each idle callback short */
+	pkg = g_queue_pop_head(&prefetch_queue);
+	if (pkg != NULL && !is_pkg_details_cached(pkg)) {
+		get_pkg_details(pkg);
+	}
+
+	if (g_queue_is_empty(&prefetch_queue)) {
+		prefetch_source_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean start_prefetch(gpointer user_data)
+{
+	prefetch_source_id = g_idle_add_full(G_PRIORITY_LOW, prefetch_next, NULL, NULL);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void queue_prefetch_row(GtkTreeModel *model, const gint row)
+{
+	GtkTreeIter iter;
+	alpm_pkg_t *pkg;
+
+	if (row >= 0 && gtk_tree_model_iter_nth_child(model, &iter, NULL, row)) {
+		gtk_tree_model_get(model, &iter, PACKAGES_COL_PKG, &pkg, -1);
+		g_queue_push_tail(&prefetch_queue, pkg);
+	}
+}
+
+static void prefetch_neighbors(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GtkTreePath *path;
+	gint row, depth, distance;
+
+	cancel_prefetch();
+
+	path = gtk_tree_model_get_path(model, iter);
+	depth = gtk_tree_path_get_depth(path);
+	row = gtk_tree_path_get_indices(path)[0];
+	gtk_tree_path_free(path);
+
+	/* rows inside an expanded group aren't numbered among the top level rows */
+	if (depth > 1) {
+		return;
+	}
+
+	/* nearest rows first, with the row below ahead of the row above since scrolling
+	 * down through the list is the most common case */
+	for (distance = 1; distance <= PREFETCH_DISTANCE; distance++) {
+		queue_prefetch_row(model, row + distance);
+		queue_prefetch_row(model, row - distance);
+	}
+
+	prefetch_source_id = g_timeout_add(PREFETCH_DELAY_MS, start_prefetch, NULL);
+}
+
 static void package_row_selected(GtkTreeSelection *selection, gpointer user_data)
 {
 	GtkTreeModel *model;
@@ -485,146 +1159,238 @@ static void package_row_selected(GtkTreeSelection *selection, gpointer user_data
 
 	if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
 		gtk_tree_model_get(model, &iter, PACKAGES_COL_PKG, &pkg, -1);
-		show_package(pkg);
+		navigate_to_package(pkg);
+		prefetch_neighbors(model, &iter);
+	}
+}
+
+static void append_smart_filter_row(GtkTreeStore *repo_tree_store, struct smart_filter_t *filter, GtkTreeIter *iter)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(repo_tree_store);
+	GtkTreeIter next;
+	gboolean found = FALSE;
+
+	/* smart filters go after the standard filters, ahead of the repositories */
+	if (gtk_tree_model_get_iter_first(model, &next)) {
+		do {
+			alpm_db_t *db;
+
+			gtk_tree_model_get(model, &next, FILTERS_COL_DB, &db, -1);
+			found = db != NULL;
+		} while (!found && gtk_tree_model_iter_next(model, &next));
+	}
+
+	gtk_tree_store_insert_before(repo_tree_store, iter, NULL, found ? &next : NULL);
+	gtk_tree_store_set(
+		repo_tree_store,
+		iter,
+		FILTERS_COL_ICON, "edit-find",
+		FILTERS_COL_TITLE, filter->name,
+		FILTERS_COL_MASK, HIDE_NONE,
+		FILTERS_COL_SMART, filter,
+		-1
+	);
+}
+
+static void append_repo_group_rows(GtkTreeStore *repo_tree_store, GtkTreeIter *parent, alpm_db_t *db)
+{
+	alpm_list_t *group_list, *i;
+
+	group_list = alpm_list_copy(alpm_db_get_groupcache(db));
+	group_list = alpm_list_msort(group_list, alpm_list_count(group_list), group_cmp);
+	for (i = group_list; i; i = i->next) {
+		alpm_group_t *group = i->data;
+
+		gtk_tree_store_insert_with_values(
+			repo_tree_store,
+			NULL,
+			parent,
+			-1,
+			FILTERS_COL_ICON, "text-x-generic",
+			FILTERS_COL_TITLE, group->name,
+			FILTERS_COL_MASK, HIDE_NONE,
+			FILTERS_COL_DB, db,
+			FILTERS_COL_GROUP, group,
+			-1
+		);
 	}
+	alpm_list_free(group_list);
+}
+
+static gboolean on_repo_test_expand(GtkTreeView *tree_view, GtkTreeIter *iter, GtkTreePath *path, gpointer user_data)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(main_window_gui.repo_tree_store);
+	GtkTreeIter child;
+	alpm_db_t *db;
+	alpm_group_t *group;
+	gint64 start_time;
+
+	if (!gtk_tree_model_iter_children(model, &child, iter)) {
+		return FALSE;
+	}
+
+	/* already expanded once */
+	gtk_tree_model_get(model, &child, FILTERS_COL_DB, &db, FILTERS_COL_GROUP, &group, -1);
+	if (group != NULL) {
+		return FALSE;
+	}
+
+	start_time = g_get_monotonic_time();
+
+	append_repo_group_rows(main_window_gui.repo_tree_store, iter, db);
+	gtk_tree_store_remove(main_window_gui.repo_tree_store, &child);
+	update_sidebar_counts();
+
+	g_debug("added %d %s groups in %" G_GINT64_FORMAT " us",
+		gtk_tree_model_iter_n_children(model, iter), alpm_db_get_name(db), g_get_monotonic_time() - start_time);
+
+	/* FALSE allows the expansion */
+	return FALSE;
 }
 
 static void populate_db_tree_view(GtkTreeStore *repo_tree_store)
 {
-	GtkIconTheme *icon_theme;
-	GdkPixbuf *icon;
-	GtkTreeIter toplevel, child;
+	GtkTreeIter toplevel;
 	alpm_list_t *i;
-
-	icon_theme = gtk_icon_theme_get_default();
+	guint f, deferred_groups = 0;
+	gint64 start_time = g_get_monotonic_time();
 
 	/* add standard filter lists */
-	icon = gtk_icon_theme_load_icon(icon_theme, "go-home", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "go-home",
 		/* l10n: filter names shown in main filter list */
 		FILTERS_COL_TITLE, _("All Packages"),
 		FILTERS_COL_MASK, HIDE_NONE,
 		-1
 	);
-	g_object_unref(icon);
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "icon-installed", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "icon-installed",
 		FILTERS_COL_TITLE, _("Installed"),
 		FILTERS_COL_MASK, HIDE_UNINSTALLED,
 		-1
 	);
-	g_object_unref(icon);
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "icon-explicit", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "icon-explicit",
 		FILTERS_COL_TITLE, _("Explicit"),
 		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_DEPEND | HIDE_OPTION | HIDE_ORPHAN,
 		-1
 	);
-	g_object_unref(icon);
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "icon-depend", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "icon-depend",
 		FILTERS_COL_TITLE, _("Dependency"),
 		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_EXPLICIT | HIDE_OPTION | HIDE_ORPHAN,
 		-1
 	);
-	g_object_unref(icon);
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "icon-optional", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "icon-optional",
 		FILTERS_COL_TITLE, _("Optional"),
 		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_EXPLICIT | HIDE_DEPEND | HIDE_ORPHAN,
 		-1
 	);
-	g_object_unref(icon);
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "icon-orphan", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "icon-orphan",
 		FILTERS_COL_TITLE, _("Orphan"),
 		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_EXPLICIT | HIDE_DEPEND | HIDE_OPTION,
 		-1
 	);
-	g_object_unref(icon);
+
+	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
+	gtk_tree_store_set(
+		repo_tree_store,
+		&toplevel,
+		FILTERS_COL_ICON, "icon-orphan",
+		FILTERS_COL_TITLE, _("Recursive Orphans"),
+		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_REACHABLE,
+		-1
+	);
+
+	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
+	gtk_tree_store_set(
+		repo_tree_store,
+		&toplevel,
+		FILTERS_COL_ICON, "dialog-warning",
+		/* l10n: installed packages with missing dependencies or conflicts */
+		FILTERS_COL_TITLE, _("Broken"),
+		FILTERS_COL_MASK, HIDE_UNINSTALLED | HIDE_INTACT,
+		-1
+	);
+
+	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
+	gtk_tree_store_set(
+		repo_tree_store,
+		&toplevel,
+		FILTERS_COL_ICON, "edit-copy",
+		/* l10n: packages hidden by a same named package in a higher priority repository */
+		FILTERS_COL_TITLE, _("Shadowed"),
+		FILTERS_COL_MASK, HIDE_UNSHADOWED,
+		-1
+	);
+
+	/* add saved smart filters */
+	for (f = 0; f < get_smart_filters()->len; f++) {
+		append_smart_filter_row(repo_tree_store, g_ptr_array_index(get_smart_filters(), f), &toplevel);
+	}
 
 	/* add known databases */
 	for (i = alpm_get_syncdbs(get_alpm_handle()); i; i = i->next) {
 		alpm_db_t *db;
-		alpm_list_t *group_list;
 
 		db = i->data;
 
-		icon = gtk_icon_theme_load_icon(icon_theme, "folder", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 		gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 		gtk_tree_store_set(
 			repo_tree_store,
 			&toplevel,
-			FILTERS_COL_ICON, icon,
+			FILTERS_COL_ICON, "folder",
 			FILTERS_COL_TITLE, alpm_db_get_name(db),
 			FILTERS_COL_MASK, HIDE_NONE,
 			FILTERS_COL_DB, db,
 			-1
 		);
-		g_object_unref(icon);
-
-		/* add any groups found for this database */
-		group_list = alpm_list_copy(alpm_db_get_groupcache(db));
-		group_list = alpm_list_msort(group_list, alpm_list_count(group_list), group_cmp);
-		for (; group_list; group_list = group_list->next) {
-			alpm_group_t *group = group_list->data;
-			icon = gtk_icon_theme_load_icon(icon_theme, "text-x-generic", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
-			gtk_tree_store_append(repo_tree_store, &child, &toplevel);
-			gtk_tree_store_set(
-				repo_tree_store,
-				&child,
-				FILTERS_COL_ICON, icon,
-				FILTERS_COL_TITLE, group->name,
-				FILTERS_COL_MASK, HIDE_NONE,
-				FILTERS_COL_DB, db,
-				FILTERS_COL_GROUP, group,
-				-1
-			);
-			g_object_unref(icon);
+
+		/* groups are only added once the database row is first expanded, until then
+		 * a placeholder row without a group makes it expandable */
+		if (alpm_db_get_groupcache(db) != NULL) {
+			gtk_tree_store_insert_with_values(repo_tree_store, NULL, &toplevel, -1, FILTERS_COL_DB, db, -1);
+			deferred_groups += alpm_list_count(alpm_db_get_groupcache(db));
 		}
-		alpm_list_free(group_list);
 	}
 
-	icon = gtk_icon_theme_load_icon(icon_theme, "drive-harddisk", 16, GTK_ICON_LOOKUP_USE_BUILTIN, NULL);
 	gtk_tree_store_append(repo_tree_store, &toplevel, NULL);
 	gtk_tree_store_set(
 		repo_tree_store,
 		&toplevel,
-		FILTERS_COL_ICON, icon,
+		FILTERS_COL_ICON, "drive-harddisk",
 		FILTERS_COL_TITLE, _("Foreign"),
 		FILTERS_COL_MASK, HIDE_NATIVE,
 		-1
 	);
-	g_object_unref(icon);
+
+	g_debug("sidebar populated in %" G_GINT64_FORMAT " us, %u group rows deferred",
+		g_get_monotonic_time() - start_time, deferred_groups);
 }
 
 static void unselect_package(void)
@@ -646,6 +1412,9 @@ static void unselect_package(void)
 	selection = gtk_tree_view_get_selection(main_window_gui.package_treeview);
 	gtk_tree_selection_unselect_all(selection);
 
+	/* neighbors of the old selection are no longer interesting */
+	cancel_prefetch();
+
 	/* clear any open package details */
 	show_package(NULL);
 }
@@ -693,13 +1462,25 @@ static void load_data(void)
 	package_filters.status_filter = HIDE_NONE;
 	package_filters.group = NULL;
 	package_filters.db = NULL;
-	package_filters.search_string = NULL;
+	g_clear_pointer(&package_filters.query_rows, bitset_free);
+	package_filters.smart_rows = NULL;
+	facet_panel_reset();
+	g_simple_action_set_enabled(remove_smart_filter_action, FALSE);
 
 	/* reset search entry */
 	gtk_entry_set_text(GTK_ENTRY(main_window_gui.search_entry), "");
 
-	/* close package view */
+	/* close package view and forget packages from the previous load */
 	show_package(NULL);
+	cancel_prefetch();
+	history_clear();
+	update_history_buttons();
+	details_cache_free();
+	g_clear_pointer(&visible_rows, bitset_free);
+	/* orphan and broken status depend on the whole graph, those filters start over */
+	smart_filters_detach(HIDE_REACHABLE | HIDE_INTACT);
+	dep_graph_free();
+	pkg_table_free();
 
 	/* reset database */
 	database_free();
@@ -711,10 +1492,23 @@ static void load_data(void)
 	/* load package list */
 	gtk_tree_view_set_model(main_window_gui.package_treeview, NULL);
 	gtk_list_store_clear(main_window_gui.package_list_store);
+	/* rows are judged as they are added, so the filters must be ready first */
+	update_visible_rows();
 	show_package_list(main_window_gui.package_list_store);
+	facet_panel_reload();
+	smart_filters_attach();
+	update_sidebar_counts();
+
+	/* the grouped list is only built once it is first shown */
+	gtk_tree_store_clear(main_window_gui.package_group_store);
+	package_groups_filled = FALSE;
+	if (group_by_base) {
+		show_package_groups(main_window_gui.package_group_store);
+	}
+
 	gtk_tree_view_set_model(
 		main_window_gui.package_treeview,
-		GTK_TREE_MODEL(main_window_gui.package_list_model)
+		GTK_TREE_MODEL(get_package_model())
 	);
 
 	/* unblock interactions */
@@ -731,6 +1525,7 @@ static void repo_row_selected(GtkTreeSelection *selection, gpointer user_data)
 	guint filters;
 	alpm_db_t *db = NULL;
 	alpm_group_t *group = NULL;
+	struct smart_filter_t *smart = NULL;
 
 	if (gtk_tree_selection_get_selected(selection, &repo_model, &repo_iter)) {
 		/* prevent selecting a different repo row while we're filtering */
@@ -743,6 +1538,7 @@ static void repo_row_selected(GtkTreeSelection *selection, gpointer user_data)
 			FILTERS_COL_MASK, &filters,
 			FILTERS_COL_DB, &db,
 			FILTERS_COL_GROUP, &group,
+			FILTERS_COL_SMART, &smart,
 			-1
 		);
 
@@ -750,138 +1546,338 @@ static void repo_row_selected(GtkTreeSelection *selection, gpointer user_data)
 		package_filters.status_filter = filters;
 		package_filters.group = group;
 		package_filters.db = db;
+		package_filters.smart_rows = NULL;
+		if (smart != NULL) {
+			package_filters.smart_rows = smart_filter_get_rows(smart);
+			package_filters.status_filter = smart->status_filter;
+			package_filters.group = smart->group;
+			package_filters.db = smart->db;
+		}
+		g_simple_action_set_enabled(remove_smart_filter_action, smart != NULL);
 
 		/* trigger refilter of package list */
-		gtk_tree_model_filter_refilter(main_window_gui.package_list_model);
+		refilter_packages();
+
+		/* if any package list row is selected then unselect it - done while the
+		 * selection signal is blocked so resetting the cursor doesn't load the first
+		 * package and record it in the navigation history */
+		unselect_package();
 
 		/* release selection blocking */
 		block_signal_package_treeview_selection(FALSE);
+	}
+}
 
-		/* if any package list row is selected then unselect it */
-		unselect_package();
+/* evaluates the filters for every package at once, leaving the visible function a
+ * lookup */
+static void update_visible_rows(void)
+{
+	struct pkg_table_t *table = get_pkg_table();
+	struct row_filter_t filter;
+	struct sidebar_sets_t sets = { NULL, NULL };
+	guint status_filter = package_filters.status_filter;
+	gint64 start_time = g_get_monotonic_time();
+
+	row_filter_init(&filter);
+
+	if (package_filters.smart_rows != NULL) {
+		row_filter_require(&filter, package_filters.smart_rows);
+	} else {
+		sidebar_filter_apply(&filter, &sets, status_filter, package_filters.db, package_filters.group);
+	}
+
+	/* a single repository view still lists everything in that repository */
+	if (package_filters.merge_repos && package_filters.db == NULL && !(status_filter & HIDE_UNSHADOWED)) {
+		row_filter_exclude(&filter, table->shadowed);
+	}
+
+	if (facet_panel_get_rows() != NULL) {
+		row_filter_require(&filter, facet_panel_get_rows());
+	}
+	if (package_filters.query_rows != NULL) {
+		row_filter_require(&filter, package_filters.query_rows);
 	}
+
+	g_clear_pointer(&visible_rows, bitset_free);
+	visible_rows = row_filter_evaluate(&filter, table->statuses, table->n_rows);
+	sidebar_sets_clear(&sets);
+
+	g_debug("filtered %u packages in %" G_GINT64_FORMAT " us, %u visible",
+		table->n_rows, g_get_monotonic_time() - start_time, bitset_count(visible_rows));
 }
 
-static gboolean is_package_filtered(const install_reason_t reason, const gchar *db_name, alpm_pkg_t *pkg)
+static gboolean is_row_visible(const guint row)
 {
-	if (package_filters.status_filter & HIDE_INSTALLED) {
-		if (reason != PKG_REASON_NOT_INSTALLED) {
-			return TRUE;
-		}
+	return visible_rows == NULL || (row != PKG_TABLE_NO_ROW && bitset_get(visible_rows, row));
+}
+
+static gboolean is_status_hidden(const guint status_filter, const install_reason_t reason)
+{
+	switch (reason) {
+		case PKG_REASON_NOT_INSTALLED:
+			return status_filter & HIDE_UNINSTALLED;
+		case PKG_REASON_EXPLICIT:
+			return status_filter & (HIDE_INSTALLED | HIDE_EXPLICIT);
+		case PKG_REASON_DEPEND:
+			return status_filter & (HIDE_INSTALLED | HIDE_DEPEND);
+		case PKG_REASON_OPTIONAL:
+			return status_filter & (HIDE_INSTALLED | HIDE_OPTION);
+		case PKG_REASON_ORPHAN:
+			return status_filter & (HIDE_INSTALLED | HIDE_ORPHAN);
 	}
 
-	if (package_filters.status_filter & HIDE_UNINSTALLED) {
-		if (reason == PKG_REASON_NOT_INSTALLED) {
-			return TRUE;
-		}
+	return FALSE;
+}
+
+static void set_sidebar_count(GtkTreeIter *iter, const guint count)
+{
+	gchar *count_str = g_strdup_printf("%u", count);
+
+	gtk_tree_store_set(main_window_gui.repo_tree_store, iter, FILTERS_COL_COUNT, count_str, -1);
+	g_free(count_str);
+}
+
+static void set_repo_counts(GtkTreeIter *iter, alpm_db_t *db, const bitset_t *base)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(main_window_gui.repo_tree_store);
+	struct pkg_table_t *table = get_pkg_table();
+	const struct facet_value_t *value;
+	bitset_t *repo_rows;
+	GtkTreeIter child;
+
+	/* a repository view doesn't merge duplicates, so its counts use the unmerged set */
+	repo_rows = bitset_copy(base);
+	value = pkg_table_find_value(table, FACET_REPO, alpm_db_get_name(db));
+	if (value != NULL) {
+		bitset_intersect(repo_rows, value->rows);
+	} else {
+		bitset_zero(repo_rows);
 	}
+	set_sidebar_count(iter, bitset_count(repo_rows));
 
-	if (package_filters.status_filter & HIDE_EXPLICIT) {
-		if (reason == PKG_REASON_EXPLICIT) {
-			return TRUE;
-		}
+	if (gtk_tree_model_iter_children(model, &child, iter)) {
+		do {
+			alpm_group_t *group;
+
+			gtk_tree_model_get(model, &child, FILTERS_COL_GROUP, &group, -1);
+			if (group == NULL) {
+				/* placeholder of groups that aren't added yet */
+				continue;
+			}
+			value = pkg_table_find_value(table, FACET_GROUP, group->name);
+			set_sidebar_count(&child, value != NULL ? bitset_count_intersection(repo_rows, value->rows) : 0);
+		} while (gtk_tree_model_iter_next(model, &child));
 	}
 
-	if (package_filters.status_filter & HIDE_DEPEND) {
-		if (reason == PKG_REASON_DEPEND) {
-			return TRUE;
-		}
+	bitset_free(repo_rows);
+}
+
+/* package counts of the sidebar rows within the current search and facets. the
+ * status rows come from one pass over the status column, repositories, groups
+ * and foreign packages are popcounts of their sets. rows depending on the whole
+ * dependency graph or saved as smart filters aren't counted */
+static void update_sidebar_counts(void)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL(main_window_gui.repo_tree_store);
+	struct pkg_table_t *table = get_pkg_table();
+	const struct facet_value_t *local;
+	bitset_t *base, *merged;
+	guint status_counts[PKG_REASON_ORPHAN + 1] = { 0 };
+	guint row, reason;
+	GtkTreeIter iter;
+
+	base = bitset_new(table->n_rows);
+	bitset_fill(base);
+	if (facet_panel_get_rows() != NULL) {
+		bitset_intersect(base, facet_panel_get_rows());
+	}
+	if (package_filters.query_rows != NULL) {
+		bitset_intersect(base, package_filters.query_rows);
 	}
 
-	if (package_filters.status_filter & HIDE_OPTION) {
-		if (reason == PKG_REASON_OPTIONAL) {
-			return TRUE;
-		}
+	merged = bitset_copy(base);
+	if (package_filters.merge_repos) {
+		bitset_subtract(merged, table->shadowed);
 	}
 
-	if (package_filters.status_filter & HIDE_ORPHAN) {
-		if (reason == PKG_REASON_ORPHAN) {
-			return TRUE;
-		}
+	for (row = 0; bitset_next(merged, &row); row++) {
+		status_counts[table->statuses[row]]++;
 	}
 
-	if (package_filters.status_filter & HIDE_NATIVE) {
-		if (g_strcmp0(db_name, "local") != 0) {
-			return TRUE;
-		}
+	local = pkg_table_find_value(table, FACET_REPO, "local");
+
+	if (gtk_tree_model_get_iter_first(model, &iter)) {
+		do {
+			guint status_filter, count = 0;
+			alpm_db_t *db;
+			struct smart_filter_t *smart;
+
+			gtk_tree_model_get(
+				model,
+				&iter,
+				FILTERS_COL_MASK, &status_filter,
+				FILTERS_COL_DB, &db,
+				FILTERS_COL_SMART, &smart,
+				-1
+			);
+
+			if (db != NULL) {
+				set_repo_counts(&iter, db, base);
+			} else if (smart == NULL && (status_filter & ~HIDE_STATUS_MASK) == 0) {
+				for (reason = PKG_REASON_NOT_INSTALLED; reason <= PKG_REASON_ORPHAN; reason++) {
+					if (!is_status_hidden(status_filter, reason)) {
+						count += status_counts[reason];
+					}
+				}
+				set_sidebar_count(&iter, count);
+			} else if (smart == NULL && status_filter == HIDE_NATIVE) {
+				set_sidebar_count(&iter, local != NULL ? bitset_count_intersection(merged, local->rows) : 0);
+			}
+		} while (gtk_tree_model_iter_next(model, &iter));
 	}
 
-	if (package_filters.status_filter & HIDE_FOREIGN) {
-		if (g_strcmp0(db_name, "local") == 0) {
-			return TRUE;
-		}
+	bitset_free(merged);
+	bitset_free(base);
+}
+
+/* recomputes the visible rows, then lets the model catch up on the main thread.
+ * the filter model signals every row that appears or disappears, and the view
+ * handles those one at a time, so when much of the list changes the view is
+ * detached and rebuilt from the model once instead */
+static void refilter_packages(void)
+{
+	struct pkg_table_t *table = get_pkg_table();
+	bitset_t *old_rows = g_steal_pointer(&visible_rows);
+	guint changed;
+
+	update_visible_rows();
+	update_sidebar_counts();
+
+	if (old_rows == NULL) {
+		changed = table->n_rows;
+	} else {
+		changed = bitset_count(old_rows) + bitset_count(visible_rows)
+			- 2 * bitset_count_intersection(old_rows, visible_rows);
+		bitset_free(old_rows);
 	}
 
-	if (package_filters.db != NULL) {
-		if (g_strcmp0(db_name, alpm_db_get_name(package_filters.db)) != 0) {
-			return TRUE;
-		}
+	if (changed == 0) {
+		return;
 	}
 
-	if (package_filters.group != NULL) {
-		alpm_list_t *pkg_groups = alpm_pkg_get_groups(pkg);
-		if (alpm_list_count(pkg_groups) == 0) {
-			return TRUE;
-		} else if (!alpm_list_find(pkg_groups, package_filters.group, group_cmp_find)) {
-			return TRUE;
-		}
+	if (changed > table->n_rows / BULK_REFILTER_DIVISOR) {
+		/* nothing should get selected while the view has no model */
+		block_signal_package_treeview_selection(TRUE);
+		gtk_tree_view_set_model(main_window_gui.package_treeview, NULL);
+		gtk_tree_model_filter_refilter(get_package_model());
+		gtk_tree_view_set_model(main_window_gui.package_treeview, GTK_TREE_MODEL(get_package_model()));
+		block_signal_package_treeview_selection(FALSE);
+	} else {
+		gtk_tree_model_filter_refilter(get_package_model());
 	}
 
-	if (package_filters.search_string != NULL) {
-		if (g_strrstr(alpm_pkg_get_name(pkg), package_filters.search_string) == NULL) {
+	g_debug("refiltered %u changed rows%s", changed,
+		changed > table->n_rows / BULK_REFILTER_DIVISOR ? " with the view detached" : "");
+}
+
+/* group rows stay visible while any of their packages is, whether or not the
+ * member rows have been filled in yet */
+static gboolean is_group_visible(const gchar *base)
+{
+	struct pkg_table_t *table = get_pkg_table();
+	GPtrArray *members = get_pkgbase_members(base);
+	guint i;
+
+	for (i = 0; members != NULL && i < members->len; i++) {
+		if (is_row_visible(pkg_table_find_row(table, g_ptr_array_index(members, i)))) {
 			return TRUE;
 		}
 	}
 
-	/* no matches, row not filtered */
 	return FALSE;
 }
 
 static gboolean row_visible(GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
 {
-	install_reason_t reason;
-	gchar *db_name;
+	gchar *base;
 	alpm_pkg_t *pkg;
+	guint row;
 	gboolean ret;
 
 	/* get row data from model */
 	gtk_tree_model_get(
 		model,
 		iter,
-		PACKAGES_COL_STATUS, &reason,
-		PACAKGES_COL_REPO, &db_name,
 		PACKAGES_COL_PKG, &pkg,
+		PACKAGES_COL_BASE, &base,
+		PACKAGES_COL_ROW, &row,
 		-1
 	);
 
-	/* check if the filters exclude this row */
-	ret = !is_package_filtered(reason, db_name, pkg);
+	if (base != NULL) {
+		ret = is_group_visible(base);
+	} else if (pkg == NULL) {
+		/* placeholder of a group that hasn't been expanded */
+		ret = TRUE;
+	} else {
+		ret = is_row_visible(row);
+	}
 
-	g_free(db_name);
+	g_free(base);
 
 	return ret;
 }
 
+static void set_search_tooltip(GtkSearchEntry *entry, const gchar *error_message)
+{
+	GtkStyleContext *context = gtk_widget_get_style_context(GTK_WIDGET(entry));
+
+	if (error_message != NULL) {
+		gtk_style_context_add_class(context, "error");
+		gtk_widget_set_tooltip_text(GTK_WIDGET(entry), error_message);
+	} else {
+		gtk_style_context_remove_class(context, "error");
+		gtk_widget_set_tooltip_text(
+			GTK_WIDGET(entry),
+			/* l10n: search entry tooltip - the field names and values stay in English */
+			_("Search names, or combine fields like: repo:core status:orphan size>10M desc:\"font\" -group:xorg\n"
+			  "Fields: name, desc, packager, repo, group, arch, license, status, size, built, installed")
+		);
+	}
+}
+
 static void on_search_changed(GtkSearchEntry *entry, gpointer user_data)
 {
+	struct query_t *query;
+	GError *error = NULL;
+
+	/* a query that doesn't parse yet is pointed out, and the list stays as it was
+	 * until further typing makes it valid */
+	query = query_parse(gtk_entry_get_text(GTK_ENTRY(entry)), &error);
+	if (query == NULL) {
+		set_search_tooltip(entry, error->message);
+		g_error_free(error);
+		return;
+	}
+	set_search_tooltip(entry, NULL);
+
 	/* block search events to prevent repeated search invocations */
 	block_signal_search_changed(TRUE);
 
 	/* prevent selecting a different repo row while we're filtering */
 	block_signal_package_treeview_selection(TRUE);
 
-	/* set filters */
-	package_filters.status_filter = HIDE_NONE;
-	package_filters.group = NULL;
-	package_filters.db = NULL;
-	package_filters.search_string = g_ascii_strdown(gtk_entry_get_text(GTK_ENTRY(entry)), -1);
+	/* the matches stay in place until the search text changes, so the sidebar,
+	 * facets and merge toggle all refilter within the search. the selected sidebar
+	 * row stays in effect too, searching narrows what it shows */
+	g_clear_pointer(&package_filters.query_rows, bitset_free);
+	if (!query_is_empty(query)) {
+		package_filters.query_rows = pkg_table_run_query(get_pkg_table(), query);
+	}
+	query_free(query);
 
 	/* trigger refilter of package list */
-	gtk_tree_model_filter_refilter(main_window_gui.package_list_model);
-
-	/* clean up */
-	g_free(package_filters.search_string);
-	package_filters.search_string = NULL;
+	refilter_packages();
 
 	/* if any package list row is selected then deselect it */
 	unselect_package();
@@ -898,6 +1894,339 @@ static void activate_about(GSimpleAction *simple, GVariant *parameter, gpointer
 	show_about_dialog(main_window_gui.window);
 }
 
+static void on_report_pkg_activated(alpm_pkg_t *pkg)
+{
+	on_deppkg_clicked(NULL, pkg);
+}
+
+static void activate_report(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
+{
+	show_report_dialog(main_window_gui.window, on_report_pkg_activated);
+}
+
+static void on_export_done(GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	GError *error = NULL;
+	GtkWidget *dialog;
+
+	g_clear_object(&export_cancellable);
+	g_simple_action_set_enabled(export_action, TRUE);
+	g_simple_action_set_enabled(export_graph_action, TRUE);
+	gtk_widget_set_sensitive(main_window_gui.refresh_button, TRUE);
+
+	if (export_packages_finish(result, &error) >= 0) {
+		return;
+	}
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		/* only when the window is closed */
+		g_error_free(error);
+		return;
+	}
+
+	dialog = gtk_message_dialog_new(
+		main_window_gui.window,
+		GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_MESSAGE_ERROR,
+		GTK_BUTTONS_CLOSE,
+		/* l10n: shown when writing an exported package list fails */
+		_("Failed to export the package list")
+	);
+	gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(dialog), "%s", error->message);
+	g_signal_connect(dialog, "response", G_CALLBACK(gtk_widget_destroy), NULL);
+	gtk_widget_show(dialog);
+
+	g_error_free(error);
+}
+
+/* the chosen file with the extension of the chosen format, since the suggested name
+ * keeps the one of the default format. NULL if the renamed file exists and the user
+ * would rather not replace it */
+static GFile *get_export_file(GtkFileChooser *file_chooser, const gchar **format_ids, const gchar *format_id)
+{
+	GFile *file, *parent, *renamed;
+	GtkWidget *dialog;
+	gchar *name, *new_name;
+	gint response;
+
+	file = gtk_file_chooser_get_file(file_chooser);
+	name = g_file_get_basename(file);
+	new_name = set_file_extension(name, format_ids, format_id);
+	if (g_strcmp0(name, new_name) == 0) {
+		g_free(name);
+		g_free(new_name);
+		return file;
+	}
+
+	parent = g_file_get_parent(file);
+	renamed = g_file_get_child(parent, new_name);
+	g_object_unref(parent);
+	g_object_unref(file);
+	g_free(name);
+
+	/* the chooser only asked about the name as it was typed */
+	if (!g_file_query_exists(renamed, NULL)) {
+		g_free(new_name);
+		return renamed;
+	}
+
+	dialog = gtk_message_dialog_new(
+		main_window_gui.window,
+		GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+		GTK_MESSAGE_QUESTION,
+		GTK_BUTTONS_NONE,
+		/* l10n: asked when an export would overwrite a file, %s is the file name */
+		_("A file named \"%s\" already exists. Do you want to replace it?"),
+		new_name
+	);
+	gtk_dialog_add_buttons(
+		GTK_DIALOG(dialog),
+		/* l10n: export overwrite dialog buttons */
+		_("_Cancel"), GTK_RESPONSE_CANCEL,
+		_("_Replace"), GTK_RESPONSE_ACCEPT,
+		NULL
+	);
+	response = gtk_dialog_run(GTK_DIALOG(dialog));
+	gtk_widget_destroy(dialog);
+	g_free(new_name);
+
+	if (response != GTK_RESPONSE_ACCEPT) {
+		g_object_unref(renamed);
+		return NULL;
+	}
+
+	return renamed;
+}
+
+/* format ids, labels and values line up, the first format is the default */
+static void show_export_dialog(const gchar *title, const gchar *default_name, const gchar **format_ids,
+                               const gchar **format_labels, const export_format_t *formats)
+{
+	/* l10n: export dialog choices */
+	const gchar *scope_ids[] = { "shown", "all", NULL };
+	const gchar *scope_labels[] = { _("Shown packages"), _("All packages"), NULL };
+	GtkFileChooserNative *chooser;
+	GtkFileChooser *file_chooser;
+	const gchar *format_id;
+	export_format_t format = formats[0];
+	bitset_t *rows = NULL;
+	GFile *file;
+	guint i, chosen = 0;
+
+	chooser = gtk_file_chooser_native_new(
+		title,
+		main_window_gui.window,
+		GTK_FILE_CHOOSER_ACTION_SAVE,
+		/* l10n: export dialog accept button */
+		_("_Export"),
+		NULL
+	);
+	file_chooser = GTK_FILE_CHOOSER(chooser);
+	gtk_file_chooser_set_do_overwrite_confirmation(file_chooser, TRUE);
+	gtk_file_chooser_set_current_name(file_chooser, default_name);
+	gtk_file_chooser_add_choice(file_chooser, "format", _("Format"), format_ids, format_labels);
+	gtk_file_chooser_set_choice(file_chooser, "format", format_ids[0]);
+	gtk_file_chooser_add_choice(file_chooser, "scope", _("Include"), scope_ids, scope_labels);
+	gtk_file_chooser_set_choice(file_chooser, "scope", "shown");
+
+	if (gtk_native_dialog_run(GTK_NATIVE_DIALOG(chooser)) != GTK_RESPONSE_ACCEPT) {
+		g_object_unref(chooser);
+		return;
+	}
+
+	format_id = gtk_file_chooser_get_choice(file_chooser, "format");
+	for (i = 0; format_ids[i] != NULL; i++) {
+		if (g_strcmp0(format_id, format_ids[i]) == 0) {
+			chosen = i;
+		}
+	}
+	format = formats[chosen];
+	file = get_export_file(file_chooser, format_ids, format_ids[chosen]);
+	if (file != NULL && g_strcmp0(gtk_file_chooser_get_choice(file_chooser, "scope"), "shown") == 0
+		&& visible_rows != NULL) {
+		rows = bitset_copy(visible_rows);
+	}
+	g_object_unref(chooser);
+	if (file == NULL) {
+		return;
+	}
+
+	/* the export reads the loaded packages until it is done */
+	g_simple_action_set_enabled(export_action, FALSE);
+	g_simple_action_set_enabled(export_graph_action, FALSE);
+	gtk_widget_set_sensitive(main_window_gui.refresh_button, FALSE);
+
+	export_cancellable = g_cancellable_new();
+	export_packages(file, format, rows, export_cancellable, on_export_done, NULL);
+	g_object_unref(file);
+}
+
+static void activate_export(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
+{
+	const gchar *format_ids[] = { "csv", "json", NULL };
+	/* l10n: package list export formats */
+	const gchar *format_labels[] = { _("CSV"), _("JSON"), NULL };
+	const export_format_t formats[] = { EXPORT_FORMAT_CSV, EXPORT_FORMAT_JSON };
+
+	/* l10n: export dialog title */
+	show_export_dialog(_("Export Package List"), "packages.csv", format_ids, format_labels, formats);
+}
+
+static void activate_export_graph(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
+{
+	const gchar *format_ids[] = { "dot", "graphml", NULL };
+	/* l10n: dependency graph export formats */
+	const gchar *format_labels[] = { _("Graphviz DOT"), _("GraphML"), NULL };
+	const export_format_t formats[] = { EXPORT_FORMAT_DOT, EXPORT_FORMAT_GRAPHML };
+
+	/* l10n: export dialog title */
+	show_export_dialog(_("Export Dependency Graph"), "packages.dot", format_ids, format_labels, formats);
+}
+
+static void on_facets_changed(void)
+{
+	block_signal_package_treeview_selection(TRUE);
+
+	refilter_packages();
+	unselect_package();
+
+	block_signal_package_treeview_selection(FALSE);
+}
+
+static void change_merge_repos(GSimpleAction *simple, GVariant *value, gpointer user_data)
+{
+	g_simple_action_set_state(simple, value);
+
+	package_filters.merge_repos = g_variant_get_boolean(value);
+	set_saved_merge_repo_duplicates(package_filters.merge_repos);
+
+	refilter_packages();
+}
+
+static void change_group_by_base(GSimpleAction *simple, GVariant *value, gpointer user_data)
+{
+	g_simple_action_set_state(simple, value);
+
+	group_by_base = g_variant_get_boolean(value);
+	set_saved_group_by_pkgbase(group_by_base);
+
+	/* prevent the model swap from selecting a package */
+	block_signal_package_treeview_selection(TRUE);
+
+	gtk_tree_view_set_model(main_window_gui.package_treeview, NULL);
+	if (group_by_base && !package_groups_filled) {
+		show_package_groups(main_window_gui.package_group_store);
+	}
+
+	/* each model keeps the filtering from when it was last shown */
+	gtk_tree_model_filter_refilter(get_package_model());
+	gtk_tree_view_set_model(
+		main_window_gui.package_treeview,
+		GTK_TREE_MODEL(get_package_model())
+	);
+
+	unselect_package();
+	block_signal_package_treeview_selection(FALSE);
+}
+
+static gboolean get_selected_repo_row(GtkTreeModel **model, GtkTreeIter *iter)
+{
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(main_window_gui.repo_treeview);
+
+	return gtk_tree_selection_get_selected(selection, model, iter);
+}
+
+/* saves the selected sidebar row, or the sidebar part of the selected smart filter,
+ * together with the query typed in the dialog */
+static void on_smart_filter_save(const gchar *name, const gchar *query)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	guint filters = HIDE_NONE;
+	alpm_db_t *db = NULL;
+	alpm_group_t *group = NULL;
+	struct smart_filter_t *smart = NULL, *filter;
+
+	if (get_selected_repo_row(&model, &iter)) {
+		gtk_tree_model_get(
+			model,
+			&iter,
+			FILTERS_COL_MASK, &filters,
+			FILTERS_COL_DB, &db,
+			FILTERS_COL_GROUP, &group,
+			FILTERS_COL_SMART, &smart,
+			-1
+		);
+	}
+
+	if (smart != NULL) {
+		filter = smart_filter_add(name, smart->status_filter, smart->db_name, smart->group_name, query);
+	} else {
+		filter = smart_filter_add(
+			name,
+			filters,
+			db != NULL ? alpm_db_get_name(db) : NULL,
+			group != NULL ? group->name : NULL,
+			query
+		);
+	}
+
+	/* selecting the new row shows it */
+	append_smart_filter_row(main_window_gui.repo_tree_store, filter, &iter);
+	gtk_tree_selection_select_iter(gtk_tree_view_get_selection(main_window_gui.repo_treeview), &iter);
+}
+
+static void activate_save_smart_filter(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	gchar *title = NULL;
+	struct smart_filter_t *smart = NULL;
+	const gchar *query = gtk_entry_get_text(GTK_ENTRY(main_window_gui.search_entry));
+
+	if (get_selected_repo_row(&model, &iter)) {
+		gtk_tree_model_get(model, &iter, FILTERS_COL_TITLE, &title, FILTERS_COL_SMART, &smart, -1);
+	}
+
+	/* starting from a smart filter without a search edits a copy of its query */
+	if (smart != NULL && *query == '\0') {
+		query = smart->query;
+	}
+
+	show_smart_filter_dialog(
+		main_window_gui.window,
+		/* l10n: sidebar part of a new smart filter when no sidebar row is selected */
+		title != NULL ? title : _("All Packages"),
+		query,
+		on_smart_filter_save
+	);
+
+	g_free(title);
+}
+
+static void activate_remove_smart_filter(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	struct smart_filter_t *smart = NULL;
+
+	if (get_selected_repo_row(&model, &iter)) {
+		gtk_tree_model_get(model, &iter, FILTERS_COL_SMART, &smart, -1);
+	}
+	if (smart == NULL) {
+		return;
+	}
+
+	/* the package list must let go of the rows before they are freed */
+	package_filters.smart_rows = NULL;
+	gtk_tree_store_remove(main_window_gui.repo_tree_store, &iter);
+	smart_filter_remove(smart);
+
+	/* fall back to all packages */
+	if (gtk_tree_model_get_iter_first(model, &iter)) {
+		gtk_tree_selection_select_iter(gtk_tree_view_get_selection(main_window_gui.repo_treeview), &iter);
+	}
+}
+
 static void activate_quit(GSimpleAction *simple, GVariant *parameter, gpointer user_data)
 {
 	exit(EXIT_SUCCESS);
@@ -906,6 +2235,13 @@ static void activate_quit(GSimpleAction *simple, GVariant *parameter, gpointer u
 static GActionGroup *create_action_group(void)
 {
 	const GActionEntry entries[] = {
+		{ "report", activate_report, NULL, NULL, NULL, { 0, 0, 0 } },
+		{ "merge-repos", NULL, NULL, "true", change_merge_repos, { 0, 0, 0 } },
+		{ "group-by-base", NULL, NULL, "false", change_group_by_base, { 0, 0, 0 } },
+		{ "save-smart-filter", activate_save_smart_filter, NULL, NULL, NULL, { 0, 0, 0 } },
+		{ "remove-smart-filter", activate_remove_smart_filter, NULL, NULL, NULL, { 0, 0, 0 } },
+		{ "export", activate_export, NULL, NULL, NULL, { 0, 0, 0 } },
+		{ "export-graph", activate_export_graph, NULL, NULL, NULL, { 0, 0, 0 } },
 		{ "about", activate_about, NULL, NULL, NULL, { 0, 0, 0 } },
 		{ "quit", activate_quit, NULL, NULL, NULL, { 0, 0, 0 } }
 	};
@@ -915,6 +2251,22 @@ static GActionGroup *create_action_group(void)
 	group = g_simple_action_group_new();
 	g_action_map_add_action_entries(G_ACTION_MAP(group), entries, G_N_ELEMENTS(entries), NULL);
 
+	/* the entry only holds a default, start from the saved preference */
+	merge_repos_action = G_SIMPLE_ACTION(g_action_map_lookup_action(G_ACTION_MAP(group), "merge-repos"));
+	g_simple_action_set_state(merge_repos_action, g_variant_new_boolean(package_filters.merge_repos));
+	group_by_base_action = G_SIMPLE_ACTION(g_action_map_lookup_action(G_ACTION_MAP(group), "group-by-base"));
+	g_simple_action_set_state(group_by_base_action, g_variant_new_boolean(group_by_base));
+
+	/* only enabled while a smart filter is selected */
+	remove_smart_filter_action = G_SIMPLE_ACTION(
+		g_action_map_lookup_action(G_ACTION_MAP(group), "remove-smart-filter")
+	);
+	g_simple_action_set_enabled(remove_smart_filter_action, FALSE);
+
+	/* both disabled while an export is running */
+	export_action = G_SIMPLE_ACTION(g_action_map_lookup_action(G_ACTION_MAP(group), "export"));
+	export_graph_action = G_SIMPLE_ACTION(g_action_map_lookup_action(G_ACTION_MAP(group), "export-graph"));
+
 	return G_ACTION_GROUP(group);
 }
 
@@ -926,6 +2278,21 @@ static GMenuModel *create_app_menu(void)
 
 	section = g_menu_new();
 	/* l10n: header menu items */
+	g_menu_insert(section, 0, _("Heaviest Packages"), "app.report");
+	g_menu_append(section, _("Merge Repository Duplicates"), "app.merge-repos");
+	g_menu_append(section, _("Group Split Packages"), "app.group-by-base");
+	g_menu_append(section, _("Export Package List…"), "app.export");
+	g_menu_append(section, _("Export Dependency Graph…"), "app.export-graph");
+	g_menu_append_section(menu, NULL, G_MENU_MODEL(section));
+	g_object_unref(section);
+
+	section = g_menu_new();
+	g_menu_insert(section, 0, _("Save Smart Filter…"), "app.save-smart-filter");
+	g_menu_append(section, _("Remove Smart Filter"), "app.remove-smart-filter");
+	g_menu_append_section(menu, NULL, G_MENU_MODEL(section));
+	g_object_unref(section);
+
+	section = g_menu_new();
 	g_menu_insert(section, 0, _("About PacFinder"), "app.about");
 	g_menu_append_section(menu, NULL, G_MENU_MODEL(section));
 	g_object_unref(section);
@@ -995,15 +2362,78 @@ static gboolean on_window_configure(GtkWindow *window, GdkEventConfigure *event)
 
 static void on_window_destroy(GtkWindow *window)
 {
+	/* a running export reads the package data freed below, it is stopped and
+	 * waited for first. the main loop keeps it going until it has wound down */
+	if (export_cancellable != NULL) {
+		g_cancellable_cancel(export_cancellable);
+		while (export_cancellable != NULL) {
+			g_main_context_iteration(NULL, TRUE);
+		}
+	}
+
+	g_clear_object(&navigation_gesture);
+	/* the row widgets go with the grids, only the bookkeeping is freed here */
+	g_clear_pointer(&opts_rows.rows, g_ptr_array_unref);
+	g_clear_pointer(&optsfor_rows.rows, g_ptr_array_unref);
+	g_clear_pointer(&package_filters.query_rows, bitset_free);
 	settings_free();
+	details_cache_free();
+	dep_graph_free();
+	smart_filters_free();
+	g_clear_pointer(&visible_rows, bitset_free);
+	pkg_table_free();
 	database_free();
+	icon_cache_free();
+}
+
+static gboolean on_window_key_press(GtkWindow *window, GdkEventKey *event)
+{
+	GdkModifierType modifiers = event->state & gtk_accelerator_get_default_mod_mask();
+
+	if (modifiers == GDK_MOD1_MASK) {
+		if (event->keyval == GDK_KEY_Left) {
+			navigate_back();
+			return GDK_EVENT_STOP;
+		} else if (event->keyval == GDK_KEY_Right) {
+			navigate_forward();
+			return GDK_EVENT_STOP;
+		}
+	}
+
+	return GDK_EVENT_PROPAGATE;
+}
+
+/* mouse back and forward buttons. the gesture runs in the capture phase, so it sees
+ * the press before any child widget can consume it */
+static void on_navigation_pressed(GtkGestureMultiPress *gesture, gint n_press, gdouble x, gdouble y, gpointer user_data)
+{
+	guint button = gtk_gesture_single_get_current_button(GTK_GESTURE_SINGLE(gesture));
+
+	if (button == 8) {
+		navigate_back();
+	} else if (button == 9) {
+		navigate_forward();
+	} else {
+		/* leave every other button to the widget under the pointer */
+		gtk_gesture_set_state(GTK_GESTURE(gesture), GTK_EVENT_SEQUENCE_DENIED);
+		return;
+	}
+
+	gtk_gesture_set_state(GTK_GESTURE(gesture), GTK_EVENT_SEQUENCE_CLAIMED);
 }
 
 static void bind_events_to_window(GtkWindow *window)
 {
 	g_signal_connect(window, "realize", G_CALLBACK(on_window_realize), NULL);
 	g_signal_connect(window, "configure-event", G_CALLBACK(on_window_configure), NULL);
+	g_signal_connect(window, "key-press-event", G_CALLBACK(on_window_key_press), NULL);
 	g_signal_connect(window, "destroy", G_CALLBACK(on_window_destroy), NULL);
+
+	navigation_gesture = gtk_gesture_multi_press_new(GTK_WIDGET(window));
+	/* any button, the handler picks out back and forward */
+	gtk_gesture_single_set_button(GTK_GESTURE_SINGLE(navigation_gesture), 0);
+	gtk_event_controller_set_propagation_phase(GTK_EVENT_CONTROLLER(navigation_gesture), GTK_PHASE_CAPTURE);
+	g_signal_connect(navigation_gesture, "pressed", G_CALLBACK(on_navigation_pressed), NULL);
 }
 
 static void save_package_column_widths(GtkTreeView *package_treeview)
@@ -1040,6 +2470,16 @@ static void on_refresh_click(GtkWidget *widget, GdkEvent *event, gpointer user_d
 	load_data();
 }
 
+static void on_back_click(GtkWidget *widget, gpointer user_data)
+{
+	navigate_back();
+}
+
+static void on_forward_click(GtkWidget *widget, gpointer user_data)
+{
+	navigate_forward();
+}
+
 static void bind_events_to_widgets(void)
 {
 	GtkTreeSelection *selection;
@@ -1062,6 +2502,70 @@ static void bind_events_to_widgets(void)
 		NULL
 	);
 
+	/* dependency, dependent and removal list item clicked */
+	g_signal_connect(
+		main_window_gui.package_details_deps_view,
+		"item-activated",
+		G_CALLBACK(on_dep_item_activated),
+		NULL
+	);
+	g_signal_connect(
+		main_window_gui.package_details_depsfor_view,
+		"item-activated",
+		G_CALLBACK(on_dep_item_activated),
+		NULL
+	);
+	g_signal_connect(
+		main_window_gui.package_removal_view,
+		"item-activated",
+		G_CALLBACK(on_dep_item_activated),
+		NULL
+	);
+	g_signal_connect(
+		main_window_gui.package_removal_broken_view,
+		"item-activated",
+		G_CALLBACK(on_dep_item_activated),
+		NULL
+	);
+
+	/* filter list repository rows expanded */
+	g_signal_connect(
+		main_window_gui.repo_treeview,
+		"test-expand-row",
+		G_CALLBACK(on_repo_test_expand),
+		NULL
+	);
+
+	/* package list group rows expanded */
+	g_signal_connect(
+		main_window_gui.package_treeview,
+		"test-expand-row",
+		G_CALLBACK(on_package_group_test_expand),
+		NULL
+	);
+
+	/* dependency tree rows expanded or activated */
+	g_signal_connect(
+		main_window_gui.package_tree_treeview,
+		"test-expand-row",
+		G_CALLBACK(on_dep_tree_test_expand),
+		NULL
+	);
+	g_signal_connect(
+		main_window_gui.package_tree_treeview,
+		"row-activated",
+		G_CALLBACK(on_dep_tree_row_activated),
+		NULL
+	);
+
+	/* details tab changed */
+	g_signal_connect(
+		main_window_gui.details_notebook,
+		"switch-page",
+		G_CALLBACK(on_details_page_switch),
+		NULL
+	);
+
 	/* search entry changed */
 	search_changed_handler_id = g_signal_connect(
 		main_window_gui.search_entry,
@@ -1078,6 +2582,20 @@ static void bind_events_to_widgets(void)
 		NULL
 	);
 
+	/* package navigation buttons click */
+	g_signal_connect(
+		main_window_gui.back_button,
+		"clicked",
+		G_CALLBACK(on_back_click),
+		NULL
+	);
+	g_signal_connect(
+		main_window_gui.forward_button,
+		"clicked",
+		G_CALLBACK(on_forward_click),
+		NULL
+	);
+
 	/* paned position change */
 	g_signal_connect(
 		main_window_gui.hpaned,
@@ -1096,8 +2614,23 @@ static void bind_events_to_widgets(void)
 
 void initialize_main_window(void)
 {
+	opts_rows.grid = main_window_gui.package_details_opts_grid;
+	optsfor_rows.grid = main_window_gui.package_details_optsfor_grid;
+	package_filters.merge_repos = get_saved_merge_repo_duplicates();
+	group_by_base = get_saved_group_by_pkgbase();
+
 	create_main_menu(main_window_gui.menu_button);
+	set_search_tooltip(GTK_SEARCH_ENTRY(main_window_gui.search_entry), NULL);
+	facet_panel_widget = create_facet_panel(on_facets_changed);
+	gtk_box_pack_end(
+		GTK_BOX(main_window_gui.sidebar_box),
+		facet_panel_widget,
+		FALSE,
+		FALSE,
+		0
+	);
 
+	gtk_widget_add_events(GTK_WIDGET(main_window_gui.window), GDK_BUTTON_PRESS_MASK);
 	bind_events_to_window(main_window_gui.window);
 	bind_events_to_widgets();
 	gtk_tree_model_filter_set_visible_func(
@@ -1106,6 +2639,12 @@ void initialize_main_window(void)
 		NULL,
 		NULL
 	);
+	gtk_tree_model_filter_set_visible_func(
+		main_window_gui.package_group_model,
+		(GtkTreeModelFilterVisibleFunc)row_visible,
+		NULL,
+		NULL
+	);
 
 	load_data();
 
@@ -18,6 +18,10 @@
 #include <glib.h>
 #include <locale.h>
 
+#include "test_bitset.h"
+#include "test_export.h"
+#include "test_query.h"
+#include "test_rowfilter.h"
 #include "test_util.h"
 
 int main(int argc, char *argv[])
@@ -27,6 +31,10 @@ int main(int argc, char *argv[])
 	g_test_init(&argc, &argv, NULL);
 	g_test_set_nonfatal_assertions();
 
+	test_bitset();
+	test_export();
+	test_query();
+	test_rowfilter();
 	test_util();
 
 	return g_test_run();
@@ -0,0 +1,124 @@
+/* test_bitset.c
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_bitset.h"
+
+#include <glib.h>
+
+#include "bitset.h"
+
+static void test_bitset_set_get(void)
+{
+	bitset_t *set = bitset_new(130);
+
+	g_assert_cmpuint(bitset_count(set), ==, 0);
+
+	bitset_set(set, 0);
+	bitset_set(set, 63);
+	bitset_set(set, 64);
+	bitset_set(set, 129);
+
+	g_assert_true(bitset_get(set, 0));
+	g_assert_true(bitset_get(set, 63));
+	g_assert_true(bitset_get(set, 64));
+	g_assert_true(bitset_get(set, 129));
+	g_assert_false(bitset_get(set, 1));
+	g_assert_false(bitset_get(set, 128));
+	g_assert_cmpuint(bitset_count(set), ==, 4);
+
+	bitset_unset(set, 63);
+	g_assert_false(bitset_get(set, 63));
+	g_assert_cmpuint(bitset_count(set), ==, 3);
+
+	bitset_fill(set);
+	g_assert_cmpuint(bitset_count(set), ==, 130);
+
+	bitset_zero(set);
+	g_assert_cmpuint(bitset_count(set), ==, 0);
+
+	bitset_free(set);
+}
+
+static void test_bitset_operations(void)
+{
+	bitset_t *set1 = bitset_new(100);
+	bitset_t *set2 = bitset_new(100);
+	bitset_t *result;
+
+	bitset_set(set1, 1);
+	bitset_set(set1, 2);
+	bitset_set(set1, 70);
+	bitset_set(set2, 2);
+	bitset_set(set2, 70);
+	bitset_set(set2, 99);
+
+	g_assert_cmpuint(bitset_count_intersection(set1, set2), ==, 2);
+
+	result = bitset_copy(set1);
+	bitset_union(result, set2);
+	g_assert_cmpuint(bitset_count(result), ==, 4);
+	bitset_free(result);
+
+	result = bitset_copy(set1);
+	bitset_intersect(result, set2);
+	g_assert_cmpuint(bitset_count(result), ==, 2);
+	g_assert_true(bitset_get(result, 2));
+	g_assert_true(bitset_get(result, 70));
+	bitset_free(result);
+
+	result = bitset_copy(set1);
+	bitset_subtract(result, set2);
+	g_assert_cmpuint(bitset_count(result), ==, 1);
+	g_assert_true(bitset_get(result, 1));
+	bitset_free(result);
+
+	bitset_free(set1);
+	bitset_free(set2);
+}
+
+static void test_bitset_next(void)
+{
+	bitset_t *empty = bitset_new(0);
+	bitset_t *set = bitset_new(200);
+	guint expected[] = { 3, 64, 127, 199 };
+	guint bit, i;
+
+	bit = 0;
+	g_assert_false(bitset_next(empty, &bit));
+
+	for (i = 0; i < G_N_ELEMENTS(expected); i++) {
+		bitset_set(set, expected[i]);
+	}
+
+	i = 0;
+	for (bit = 0; bitset_next(set, &bit); bit++) {
+		g_assert_cmpuint(i, <, G_N_ELEMENTS(expected));
+		g_assert_cmpuint(bit, ==, expected[i]);
+		i++;
+	}
+	g_assert_cmpuint(i, ==, G_N_ELEMENTS(expected));
+
+	bitset_free(empty);
+	bitset_free(set);
+}
+
+void test_bitset(void)
+{
+	g_test_add_func("/bitset/set_get", test_bitset_set_get);
+	g_test_add_func("/bitset/operations", test_bitset_operations);
+	g_test_add_func("/bitset/next", test_bitset_next);
+}
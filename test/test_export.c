@@ -0,0 +1,266 @@
+/* test_export.c
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_export.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "bitset.h"
+#include "database.h"
+#include "export.h"
+#include "exportformat.h"
+#include "pkgtable.h"
+
+static void assert_escaped(const gchar *str, const gchar *(*escape)(const gchar c, gchar *buf), const gchar *expected)
+{
+	GString *out = g_string_new(NULL);
+
+	export_append_escaped(out, str, escape);
+	g_assert_cmpstr(out->str, ==, expected);
+	g_string_free(out, TRUE);
+}
+
+static void test_export_escape(void)
+{
+	assert_escaped("", export_dot_escape, "");
+	assert_escaped("plain", export_dot_escape, "plain");
+	assert_escaped("\"quoted\"", export_dot_escape, "\\\"quoted\\\"");
+	assert_escaped("back\\slash\nline", export_dot_escape, "back\\\\slash\\nline");
+	assert_escaped("<a & b>", export_dot_escape, "<a & b>");
+
+	assert_escaped("", export_xml_escape, "");
+	assert_escaped("plain", export_xml_escape, "plain");
+	assert_escaped("<a & \"b\">", export_xml_escape, "&lt;a &amp; &quot;b&quot;&gt;");
+	assert_escaped("&&", export_xml_escape, "&amp;&amp;");
+	assert_escaped("back\\slash", export_xml_escape, "back\\slash");
+
+	assert_escaped("say \"hi\"", export_csv_escape, "say \"\"hi\"\"");
+	assert_escaped("say \"hi\"\\\n\t\x01é", export_json_escape, "say \\\"hi\\\"\\\\\\n\\t\\u0001é");
+}
+
+static void test_export_json_string(void)
+{
+	GString *out = g_string_new(NULL);
+
+	export_append_json_string(out, NULL);
+	g_assert_cmpstr(out->str, ==, "null");
+
+	g_string_truncate(out, 0);
+	export_append_json_string(out, "");
+	g_assert_cmpstr(out->str, ==, "\"\"");
+
+	g_string_truncate(out, 0);
+	export_append_json_string(out, "a \"b\"");
+	g_assert_cmpstr(out->str, ==, "\"a \\\"b\\\"\"");
+
+	g_string_free(out, TRUE);
+}
+
+/* one package per node, with a name needing escapes */
+static const struct export_row_t node_row = {
+	.row = 3,
+	.name = "a<\"b\">&c",
+	.version = "1.0-1",
+	.repo = "core",
+	.status = PKG_REASON_EXPLICIT,
+	.size = 1024,
+	.download_size = -1,
+	.description = NULL,
+	.packager = NULL,
+	.built = 0,
+	.installed = 0,
+	.depends = NULL,
+	.optdepends = NULL
+};
+
+static const struct export_edge_t edge = { 3, 7, EDGE_OPTDEPENDS };
+
+static gchar *write_graph(const export_format_t format)
+{
+	GString *out = g_string_new(NULL);
+
+	export_append_header(out, format);
+	export_append_row(out, format, &node_row, 0);
+	export_append_edge(out, format, &edge);
+	export_append_footer(out, format, 1);
+
+	return g_string_free(out, FALSE);
+}
+
+static alpm_depend_t dep_bar = { .name = "bar", .version = "1.2", .mod = ALPM_DEP_MOD_GE };
+static alpm_depend_t dep_baz = { .name = "baz", .mod = ALPM_DEP_MOD_ANY };
+static alpm_depend_t dep_qux = { .name = "qux", .version = "2", .mod = ALPM_DEP_MOD_LT };
+
+/* a repository package with dependencies and a field needing quotes, then an
+ * installed one only in the local database and without dependencies */
+static gchar *write_rows(const export_format_t format)
+{
+	struct export_row_t repo_row = {
+		.row = 5,
+		.name = "foo",
+		.version = "1:2.0-1",
+		.repo = "extra",
+		.status = PKG_REASON_NOT_INSTALLED,
+		.size = 2048,
+		.download_size = 512,
+		.description = "says \"hi\", twice",
+		.packager = NULL,
+		.built = 86400,
+		.installed = 0
+	};
+	const struct export_row_t local_row = {
+		.row = 6,
+		.name = "foo-docs",
+		.version = "1.0-1",
+		.repo = "local",
+		.status = PKG_REASON_DEPEND,
+		.size = 100,
+		.download_size = -1,
+		.description = "docs",
+		.packager = "A <a@b.c>",
+		.built = 86400,
+		.installed = 172800,
+		.depends = NULL,
+		.optdepends = NULL
+	};
+	GString *out = g_string_new(NULL);
+
+	repo_row.depends = alpm_list_add(NULL, &dep_bar);
+	repo_row.depends = alpm_list_add(repo_row.depends, &dep_baz);
+	repo_row.optdepends = alpm_list_add(NULL, &dep_qux);
+
+	export_append_header(out, format);
+	export_append_row(out, format, &repo_row, 0);
+	export_append_row(out, format, &local_row, 1);
+	export_append_footer(out, format, 2);
+
+	alpm_list_free(repo_row.depends);
+	alpm_list_free(repo_row.optdepends);
+
+	return g_string_free(out, FALSE);
+}
+
+static void test_export_csv(void)
+{
+	gchar *output = write_rows(EXPORT_FORMAT_CSV);
+
+	g_assert_cmpstr(output, ==,
+		"name,version,repo,status,size,download_size,description,packager,built,installed,depends,optdepends\n"
+		"foo,1:2.0-1,extra,uninstalled,2048,512,\"says \"\"hi\"\", twice\",,1970-01-02T00:00:00Z,,\"bar>=1.2 baz\",\"qux<2\"\n"
+		"foo-docs,1.0-1,local,depend,100,,docs,A <a@b.c>,1970-01-02T00:00:00Z,1970-01-03T00:00:00Z,\"\",\"\"\n");
+	g_free(output);
+}
+
+/* the same rows --query prints with --format=json */
+static void test_export_json(void)
+{
+	gchar *output = write_rows(EXPORT_FORMAT_JSON);
+
+	g_assert_cmpstr(output, ==,
+		"[\n"
+		"{\"name\":\"foo\",\"version\":\"1:2.0-1\",\"repo\":\"extra\",\"status\":\"uninstalled\",\"size\":2048,"
+		"\"download_size\":512,\"description\":\"says \\\"hi\\\", twice\",\"packager\":null,"
+		"\"built\":86400,\"installed\":null,\"depends\":[\"bar>=1.2\",\"baz\"],\"optdepends\":[\"qux<2\"]},\n"
+		"{\"name\":\"foo-docs\",\"version\":\"1.0-1\",\"repo\":\"local\",\"status\":\"depend\",\"size\":100,"
+		"\"download_size\":null,\"description\":\"docs\",\"packager\":\"A <a@b.c>\","
+		"\"built\":86400,\"installed\":172800,\"depends\":[],\"optdepends\":[]}\n"
+		"]\n");
+	g_free(output);
+}
+
+static void test_export_dot(void)
+{
+	gchar *output = write_graph(EXPORT_FORMAT_DOT);
+
+	g_assert_cmpstr(output, ==,
+		"digraph packages {\n"
+		"\tnode [shape=box];\n"
+		"\tn3 [label=\"a<\\\"b\\\">&c\", version=\"1.0-1\", repo=\"core\", status=\"explicit\", size=1024];\n"
+		"\tn3 -> n7 [type=\"optdepends\", style=dashed];\n"
+		"}\n");
+	g_free(output);
+}
+
+static void test_export_graphml(void)
+{
+	gchar *output = write_graph(EXPORT_FORMAT_GRAPHML);
+
+	g_assert_true(g_str_has_prefix(output, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<graphml "));
+	g_assert_nonnull(strstr(output,
+		"  <graph id=\"packages\" edgedefault=\"directed\">\n"
+		"    <node id=\"n3\"><data key=\"name\">a&lt;&quot;b&quot;&gt;&amp;c</data>"
+		"<data key=\"version\">1.0-1</data><data key=\"repo\">core</data>"
+		"<data key=\"status\">explicit</data><data key=\"size\">1024</data></node>\n"
+		"    <edge source=\"n3\" target=\"n7\"><data key=\"type\">optdepends</data></edge>\n"
+		"  </graph>\n"
+		"</graphml>\n"));
+	g_assert_true(g_str_has_suffix(output, "</graphml>\n"));
+	g_free(output);
+}
+
+/* an edge is only written when both ends are, the shown rows may leave either out */
+static void test_export_add_edge(void)
+{
+	GArray *edges = g_array_new(FALSE, FALSE, sizeof(struct export_edge_t));
+	bitset_t *rows = bitset_new(8);
+	struct export_edge_t *kept;
+
+	bitset_set(rows, 1);
+	bitset_set(rows, 3);
+	bitset_set(rows, 5);
+
+	export_add_edge(edges, rows, 1, 3, EDGE_DEPENDS);
+	export_add_edge(edges, rows, 1, 4, EDGE_DEPENDS);
+	export_add_edge(edges, rows, 1, PKG_TABLE_NO_ROW, EDGE_OPTDEPENDS);
+	export_add_edge(edges, rows, 3, 5, EDGE_PROVIDES);
+	export_add_edge(edges, rows, 5, 0, EDGE_OPTDEPENDS);
+
+	g_assert_cmpuint(edges->len, ==, 2);
+
+	kept = &g_array_index(edges, struct export_edge_t, 0);
+	g_assert_cmpuint(kept->source, ==, 1);
+	g_assert_cmpuint(kept->target, ==, 3);
+	g_assert_cmpint(kept->type, ==, EDGE_DEPENDS);
+
+	kept = &g_array_index(edges, struct export_edge_t, 1);
+	g_assert_cmpuint(kept->source, ==, 3);
+	g_assert_cmpuint(kept->target, ==, 5);
+	g_assert_cmpint(kept->type, ==, EDGE_PROVIDES);
+
+	/* every row exported keeps them all */
+	g_array_set_size(edges, 0);
+	bitset_fill(rows);
+	export_add_edge(edges, rows, 1, 4, EDGE_DEPENDS);
+	export_add_edge(edges, rows, 5, 0, EDGE_OPTDEPENDS);
+	export_add_edge(edges, rows, 1, PKG_TABLE_NO_ROW, EDGE_OPTDEPENDS);
+	g_assert_cmpuint(edges->len, ==, 2);
+
+	bitset_free(rows);
+	g_array_free(edges, TRUE);
+}
+
+void test_export(void)
+{
+	g_test_add_func("/export/escape", test_export_escape);
+	g_test_add_func("/export/json_string", test_export_json_string);
+	g_test_add_func("/export/csv", test_export_csv);
+	g_test_add_func("/export/json", test_export_json);
+	g_test_add_func("/export/dot", test_export_dot);
+	g_test_add_func("/export/graphml", test_export_graphml);
+	g_test_add_func("/export/add_edge", test_export_add_edge);
+}
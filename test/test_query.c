@@ -0,0 +1,324 @@
+/* test_query.c
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_query.h"
+
+#include <glib.h>
+
+#include "bitset.h"
+#include "database.h"
+#include "pkgtable.h"
+#include "query.h"
+#include "util.h"
+
+static struct query_term_t *get_term(const struct query_t *query, const guint index)
+{
+	return g_ptr_array_index(query->terms, index);
+}
+
+static void test_query_parse(void)
+{
+	GError *error = NULL;
+	struct query_t *query;
+	struct query_term_t *term;
+
+	query = query_parse("repo:core status:orphan size>10M desc:\"Font Tools\" -group:xorg", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_cmpuint(query->terms->len, ==, 5);
+
+	term = get_term(query, 0);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_REPO);
+	g_assert_false(term->negate);
+	g_assert_cmpstr(term->text, ==, "core");
+
+	term = get_term(query, 1);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_STATUS);
+	g_assert_cmpuint(term->status_mask, ==, 1 << PKG_REASON_ORPHAN);
+
+	term = get_term(query, 2);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_SIZE);
+	g_assert_cmpint(term->cmp, ==, QUERY_CMP_GT);
+	g_assert_cmpint(term->size, ==, 10 * 1024 * 1024);
+
+	term = get_term(query, 3);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_DESC);
+	g_assert_cmpstr(term->text, ==, "font tools");
+
+	term = get_term(query, 4);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_GROUP);
+	g_assert_true(term->negate);
+	g_assert_cmpstr(term->text, ==, "xorg");
+
+	query_free(query);
+
+	/* bare words search names */
+	query = query_parse("  GTK  ", &error);
+	g_assert_no_error(error);
+	g_assert_cmpuint(query->terms->len, ==, 1);
+	term = get_term(query, 0);
+	g_assert_cmpint(term->field, ==, QUERY_FIELD_NAME);
+	g_assert_cmpstr(term->text, ==, "gtk");
+	query_free(query);
+
+	/* a lone dash is a word, not a negation */
+	query = query_parse("-", &error);
+	g_assert_no_error(error);
+	g_assert_false(get_term(query, 0)->negate);
+	g_assert_cmpstr(get_term(query, 0)->text, ==, "-");
+	query_free(query);
+
+	query = query_parse("", &error);
+	g_assert_no_error(error);
+	g_assert_true(query_is_empty(query));
+	query_free(query);
+}
+
+static void test_query_parse_dates(void)
+{
+	GError *error = NULL;
+	struct query_t *query;
+	gint64 year, next_year, day, next_day;
+
+	g_assert_true(parse_date("2023", &year));
+	g_assert_true(parse_date("2024", &next_year));
+	g_assert_true(parse_date("2023-05-01", &day));
+	g_assert_true(parse_date("2023-05-02", &next_day));
+
+	query = query_parse("built:2023 installed<2023-05-01 installed<=2023-05-01 built>2023 built>=2023", &error);
+	g_assert_no_error(error);
+	g_assert_cmpuint(query->terms->len, ==, 5);
+
+	g_assert_cmpint(get_term(query, 0)->from, ==, year);
+	g_assert_cmpint(get_term(query, 0)->to, ==, next_year);
+
+	g_assert_cmpint(get_term(query, 1)->from, ==, G_MININT64);
+	g_assert_cmpint(get_term(query, 1)->to, ==, day);
+
+	g_assert_cmpint(get_term(query, 2)->to, ==, next_day);
+
+	g_assert_cmpint(get_term(query, 3)->from, ==, next_year);
+	g_assert_cmpint(get_term(query, 3)->to, ==, G_MAXINT64);
+
+	g_assert_cmpint(get_term(query, 4)->from, ==, year);
+
+	query_free(query);
+}
+
+static void test_query_parse_errors(void)
+{
+	const struct {
+		const gchar *query;
+		query_error_t code;
+	} invalid[] = {
+		{ "colour:red", QUERY_ERROR_FIELD },
+		{ "size>lots", QUERY_ERROR_VALUE },
+		{ "size>", QUERY_ERROR_SYNTAX },
+		{ "desc:\"font", QUERY_ERROR_SYNTAX },
+		{ "status:bogus", QUERY_ERROR_VALUE },
+		{ "built:yesterday", QUERY_ERROR_VALUE },
+		{ "repo>core", QUERY_ERROR_SYNTAX },
+		{ "size>9999999999G", QUERY_ERROR_VALUE },
+		{ "size>nan", QUERY_ERROR_VALUE }
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(invalid); i++) {
+		GError *error = NULL;
+
+		g_assert_null(query_parse(invalid[i].query, &error));
+		g_assert_error(error, QUERY_ERROR, invalid[i].code);
+		g_clear_error(&error);
+	}
+}
+
+static void add_facet_value(struct pkg_table_t *table, const facet_t facet, const gchar *value, const guint row)
+{
+	struct facet_value_t *entry;
+
+	entry = g_hash_table_lookup(table->facet_index[facet], value);
+	if (entry == NULL) {
+		entry = g_new(struct facet_value_t, 1);
+		entry->value = value;
+		entry->rows = bitset_new(table->n_rows);
+		g_ptr_array_add(table->facets[facet], entry);
+		g_hash_table_insert(table->facet_index[facet], (gpointer)value, entry);
+	}
+	bitset_set(entry->rows, row);
+}
+
+static void free_facet_value(gpointer data)
+{
+	struct facet_value_t *entry = data;
+
+	bitset_free(entry->rows);
+	g_free(entry);
+}
+
+/* four packages with just the columns and lookups queries read, the dates are
+ * passed in ascending order */
+static struct pkg_table_t *build_table(void)
+{
+	static const gchar *names[] = { "bash", "bash-completion", "zsh", "xterm" };
+	static const gchar *descs[] = { "the gnu shell", "completions for bash", "the z shell", "x terminal" };
+	static const gchar *build_dates[] = { "2021-06-01", "2022-03-10", "2022-03-20", "2023-01-01" };
+	static const off_t sizes[] = { 8 * 1024 * 1024, 900 * 1024, 6 * 1024 * 1024, 1024 * 1024 };
+	static const install_reason_t statuses[] = {
+		PKG_REASON_EXPLICIT, PKG_REASON_DEPEND, PKG_REASON_NOT_INSTALLED, PKG_REASON_ORPHAN
+	};
+	struct pkg_table_t *table;
+	guint row;
+	facet_t facet;
+
+	table = g_new0(struct pkg_table_t, 1);
+	table->n_rows = G_N_ELEMENTS(names);
+	for (facet = 0; facet < NUM_FACETS; facet++) {
+		table->facets[facet] = g_ptr_array_new_with_free_func(free_facet_value);
+		table->facet_index[facet] = g_hash_table_new(g_str_hash, g_str_equal);
+	}
+
+	/* in value order, as the real table keeps them */
+	add_facet_value(table, FACET_REPO, "core", 0);
+	add_facet_value(table, FACET_REPO, "extra", 1);
+	add_facet_value(table, FACET_REPO, "extra", 2);
+	add_facet_value(table, FACET_REPO, "extra", 3);
+	add_facet_value(table, FACET_LICENSE, "GPL3", 0);
+	add_facet_value(table, FACET_LICENSE, "GPL3", 1);
+	add_facet_value(table, FACET_LICENSE, "MIT", 3);
+	add_facet_value(table, FACET_LICENSE, "gpl3", 2);
+
+	table->n_dates[DATE_BUILD] = table->n_rows;
+	table->dates[DATE_BUILD] = g_new(gint64, table->n_rows);
+	table->date_rows[DATE_BUILD] = g_new(guint, table->n_rows);
+
+	table->sizes = g_new(off_t, table->n_rows);
+	table->statuses = g_new(install_reason_t, table->n_rows);
+	table->names = g_new(gchar *, table->n_rows);
+	table->descs = g_new(gchar *, table->n_rows);
+	table->packagers = g_new(gchar *, table->n_rows);
+
+	for (row = 0; row < table->n_rows; row++) {
+		gboolean parsed = parse_date(build_dates[row], &table->dates[DATE_BUILD][row]);
+
+		g_assert_true(parsed);
+		table->date_rows[DATE_BUILD][row] = row;
+		table->sizes[row] = sizes[row];
+		table->statuses[row] = statuses[row];
+		table->names[row] = (gchar *)names[row];
+		table->descs[row] = (gchar *)descs[row];
+		table->packagers[row] = "";
+	}
+
+	return table;
+}
+
+static void free_table(struct pkg_table_t *table)
+{
+	facet_t facet;
+
+	for (facet = 0; facet < NUM_FACETS; facet++) {
+		g_ptr_array_free(table->facets[facet], TRUE);
+		g_hash_table_destroy(table->facet_index[facet]);
+	}
+	g_free(table->dates[DATE_BUILD]);
+	g_free(table->date_rows[DATE_BUILD]);
+	g_free(table->sizes);
+	g_free(table->statuses);
+	g_free(table->names);
+	g_free(table->descs);
+	g_free(table->packagers);
+	g_free(table);
+}
+
+/* the rows a query leaves, as a bit per row */
+static guint run_query(const struct pkg_table_t *table, const gchar *text)
+{
+	GError *error = NULL;
+	struct query_t *query;
+	bitset_t *rows;
+	guint bit, mask = 0;
+
+	query = query_parse(text, &error);
+	g_assert_no_error(error);
+
+	rows = pkg_table_run_query(table, query);
+	for (bit = 0; bitset_next(rows, &bit); bit++) {
+		mask |= 1 << bit;
+	}
+
+	bitset_free(rows);
+	query_free(query);
+
+	return mask;
+}
+
+static void test_query_evaluate(void)
+{
+	struct pkg_table_t *table = build_table();
+
+	g_assert_cmpuint(run_query(table, ""), ==, 0xF);
+
+	/* names, descriptions */
+	g_assert_cmpuint(run_query(table, "bash"), ==, 0x3);
+	g_assert_cmpuint(run_query(table, "BASH"), ==, 0x3);
+	g_assert_cmpuint(run_query(table, "-bash"), ==, 0xC);
+	g_assert_cmpuint(run_query(table, "desc:shell"), ==, 0x5);
+	g_assert_cmpuint(run_query(table, "desc:shell -zsh"), ==, 0x1);
+
+	/* facets, ignoring case */
+	g_assert_cmpuint(run_query(table, "repo:extra"), ==, 0xE);
+	g_assert_cmpuint(run_query(table, "repo:Core"), ==, 0x1);
+	g_assert_cmpuint(run_query(table, "-repo:core"), ==, 0xE);
+	g_assert_cmpuint(run_query(table, "license:gpl3"), ==, 0x7);
+	g_assert_cmpuint(run_query(table, "license:GPL3 -bash"), ==, 0x4);
+
+	/* unknown values match nothing, and everything negated */
+	g_assert_cmpuint(run_query(table, "repo:testing"), ==, 0x0);
+	g_assert_cmpuint(run_query(table, "-repo:testing"), ==, 0xF);
+	g_assert_cmpuint(run_query(table, "group:xorg"), ==, 0x0);
+	g_assert_cmpuint(run_query(table, "nosuchpackage"), ==, 0x0);
+
+	/* sizes, with the bounds */
+	g_assert_cmpuint(run_query(table, "size>1M"), ==, 0x5);
+	g_assert_cmpuint(run_query(table, "size>=1M"), ==, 0xD);
+	g_assert_cmpuint(run_query(table, "size<1M"), ==, 0x2);
+	g_assert_cmpuint(run_query(table, "size:1M"), ==, 0x8);
+	g_assert_cmpuint(run_query(table, "size>1M size<8M"), ==, 0x4);
+	g_assert_cmpuint(run_query(table, "-size>1M"), ==, 0xA);
+
+	/* dates cover the whole period typed */
+	g_assert_cmpuint(run_query(table, "built:2022"), ==, 0x6);
+	g_assert_cmpuint(run_query(table, "built:2022-03-20"), ==, 0x4);
+	g_assert_cmpuint(run_query(table, "built<2022-03"), ==, 0x1);
+	g_assert_cmpuint(run_query(table, "built>2022"), ==, 0x8);
+	g_assert_cmpuint(run_query(table, "-built:2022"), ==, 0x9);
+	g_assert_cmpuint(run_query(table, "installed:2022"), ==, 0x0);
+
+	/* statuses */
+	g_assert_cmpuint(run_query(table, "status:orphan"), ==, 0x8);
+	g_assert_cmpuint(run_query(table, "-status:explicit repo:extra"), ==, 0xE);
+
+	free_table(table);
+}
+
+void test_query(void)
+{
+	g_test_add_func("/query/parse", test_query_parse);
+	g_test_add_func("/query/parse_dates", test_query_parse_dates);
+	g_test_add_func("/query/parse_errors", test_query_parse_errors);
+	g_test_add_func("/query/evaluate", test_query_evaluate);
+}
@@ -0,0 +1,227 @@
+/* test_rowfilter.c
+ *
+ * Copyright 2022 Steven Benner
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_rowfilter.h"
+
+#include <glib.h>
+
+#include "bitset.h"
+#include "database.h"
+#include "rowfilter.h"
+
+#define BENCHMARK_RUNS 20
+
+struct synthetic_table_t {
+	guint n_rows;
+	install_reason_t *statuses;
+	bitset_t *repo;
+	bitset_t *shadowed;
+	bitset_t *query;
+};
+
+/* the same filter checked one row at a time, the way the visible function did */
+static bitset_t *evaluate_serially(const struct row_filter_t *filter, const install_reason_t *statuses, const guint n_rows)
+{
+	bitset_t *result = bitset_new(n_rows);
+	guint row, i;
+
+	for (row = 0; row < n_rows && !filter->match_none; row++) {
+		gboolean visible = (filter->hidden_statuses & (1 << statuses[row])) == 0;
+
+		for (i = 0; i < filter->n_required && visible; i++) {
+			visible = bitset_get(filter->required[i], row);
+		}
+		for (i = 0; i < filter->n_excluded && visible; i++) {
+			visible = !bitset_get(filter->excluded[i], row);
+		}
+
+		if (visible) {
+			bitset_set(result, row);
+		}
+	}
+
+	return result;
+}
+
+static void assert_same_rows(const bitset_t *set1, const bitset_t *set2)
+{
+	guint i;
+
+	g_assert_cmpuint(set1->size, ==, set2->size);
+	for (i = 0; i < set1->n_words; i++) {
+		g_assert_cmpuint(set1->words[i], ==, set2->words[i]);
+	}
+}
+
+static bitset_t *random_rows(const guint n_rows, const gdouble density)
+{
+	bitset_t *set = bitset_new(n_rows);
+	guint row;
+
+	for (row = 0; row < n_rows; row++) {
+		if (g_test_rand_double() < density) {
+			bitset_set(set, row);
+		}
+	}
+
+	return set;
+}
+
+static struct synthetic_table_t *synthetic_table_new(const guint n_rows)
+{
+	struct synthetic_table_t *table = g_new(struct synthetic_table_t, 1);
+	guint row;
+
+	table->n_rows = n_rows;
+	table->statuses = g_new(install_reason_t, n_rows);
+	for (row = 0; row < n_rows; row++) {
+		table->statuses[row] = g_test_rand_int_range(PKG_REASON_NOT_INSTALLED, PKG_REASON_ORPHAN + 1);
+	}
+	table->repo = random_rows(n_rows, 0.25);
+	table->shadowed = random_rows(n_rows, 0.02);
+	table->query = random_rows(n_rows, 0.3);
+
+	return table;
+}
+
+static void synthetic_table_free(struct synthetic_table_t *table)
+{
+	bitset_free(table->query);
+	bitset_free(table->shadowed);
+	bitset_free(table->repo);
+	g_free(table->statuses);
+	g_free(table);
+}
+
+/* installed packages of one repository matching a search, with duplicates merged */
+static void set_synthetic_filter(struct row_filter_t *filter, const struct synthetic_table_t *table)
+{
+	row_filter_init(filter);
+	filter->hidden_statuses = 1 << PKG_REASON_NOT_INSTALLED;
+	row_filter_require(filter, table->repo);
+	row_filter_require(filter, table->query);
+	row_filter_exclude(filter, table->shadowed);
+}
+
+static void test_row_filter_evaluate(void)
+{
+	install_reason_t statuses[130];
+	bitset_t *even, *thirds, *result, *expected;
+	struct row_filter_t filter;
+	guint row;
+
+	even = bitset_new(130);
+	thirds = bitset_new(130);
+	for (row = 0; row < 130; row++) {
+		statuses[row] = row % 5;
+		if (row % 2 == 0) {
+			bitset_set(even, row);
+		}
+		if (row % 3 == 0) {
+			bitset_set(thirds, row);
+		}
+	}
+
+	/* no conditions shows every row, and nothing past the last one */
+	row_filter_init(&filter);
+	result = row_filter_evaluate(&filter, statuses, 130);
+	g_assert_cmpuint(bitset_count(result), ==, 130);
+	bitset_free(result);
+
+	filter.hidden_statuses = 1 << PKG_REASON_ORPHAN;
+	row_filter_require(&filter, even);
+	row_filter_exclude(&filter, thirds);
+	row_filter_exclude(&filter, NULL);
+	result = row_filter_evaluate(&filter, statuses, 130);
+	expected = evaluate_serially(&filter, statuses, 130);
+	assert_same_rows(result, expected);
+	g_assert_true(bitset_get(result, 2));
+	g_assert_false(bitset_get(result, 4));
+	g_assert_false(bitset_get(result, 6));
+	bitset_free(expected);
+	bitset_free(result);
+
+	/* a required set that doesn't exist matches nothing */
+	row_filter_require(&filter, NULL);
+	result = row_filter_evaluate(&filter, statuses, 130);
+	g_assert_cmpuint(bitset_count(result), ==, 0);
+	bitset_free(result);
+
+	result = row_filter_evaluate(&filter, statuses, 0);
+	g_assert_cmpuint(bitset_count(result), ==, 0);
+	bitset_free(result);
+
+	bitset_free(thirds);
+	bitset_free(even);
+}
+
+/* large enough to be split across threads, which must agree with one thread */
+static void test_row_filter_threads(void)
+{
+	struct synthetic_table_t *table = synthetic_table_new(200000 + 7);
+	struct row_filter_t filter;
+	bitset_t *result, *expected;
+
+	set_synthetic_filter(&filter, table);
+	result = row_filter_evaluate(&filter, table->statuses, table->n_rows);
+	expected = evaluate_serially(&filter, table->statuses, table->n_rows);
+	assert_same_rows(result, expected);
+
+	bitset_free(expected);
+	bitset_free(result);
+	synthetic_table_free(table);
+}
+
+static void benchmark_row_filter(gconstpointer data)
+{
+	struct synthetic_table_t *table = synthetic_table_new(GPOINTER_TO_UINT(data));
+	struct row_filter_t filter;
+	gdouble serial, parallel;
+	guint i;
+
+	set_synthetic_filter(&filter, table);
+
+	g_test_timer_start();
+	for (i = 0; i < BENCHMARK_RUNS; i++) {
+		bitset_free(evaluate_serially(&filter, table->statuses, table->n_rows));
+	}
+	serial = g_test_timer_elapsed() / BENCHMARK_RUNS;
+
+	g_test_timer_start();
+	for (i = 0; i < BENCHMARK_RUNS; i++) {
+		bitset_free(row_filter_evaluate(&filter, table->statuses, table->n_rows));
+	}
+	parallel = g_test_timer_elapsed() / BENCHMARK_RUNS;
+
+	g_test_message("%u packages: row by row %.3f ms, parallel words %.3f ms on %u threads",
+		table->n_rows, serial * 1000, parallel * 1000, g_get_num_processors());
+	g_test_minimized_result(parallel, "filter %u packages in %.3f ms", table->n_rows, parallel * 1000);
+
+	synthetic_table_free(table);
+}
+
+void test_rowfilter(void)
+{
+	g_test_add_func("/rowfilter/evaluate", test_row_filter_evaluate);
+	g_test_add_func("/rowfilter/threads", test_row_filter_threads);
+
+	/* run with -m perf */
+	if (g_test_perf()) {
+		g_test_add_data_func("/rowfilter/benchmark/15k", GUINT_TO_POINTER(15000), benchmark_row_filter);
+		g_test_add_data_func("/rowfilter/benchmark/200k", GUINT_TO_POINTER(200000), benchmark_row_filter);
+	}
+}
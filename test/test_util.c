@@ -120,9 +120,75 @@ static void test_strtrunc_dep_desc(void)
 	g_free(prov_version);
 }
 
+static void test_parse_date(void)
+{
+	gint64 year, month, day, next_day, invalid;
+
+	g_assert_true(parse_date("2023", &year));
+	g_assert_true(parse_date("2023-01", &month));
+	g_assert_true(parse_date("2023-01-01", &day));
+	g_assert_true(parse_date("2023-01-02", &next_day));
+
+	g_assert_cmpint(year, ==, day);
+	g_assert_cmpint(month, ==, day);
+	g_assert_cmpint(next_day - day, ==, 24 * 60 * 60);
+
+	g_assert_false(parse_date("", &invalid));
+	g_assert_false(parse_date("pacfinder", &invalid));
+	g_assert_false(parse_date("2023x", &invalid));
+	g_assert_false(parse_date("2023-13", &invalid));
+	g_assert_false(parse_date("2023-02-30", &invalid));
+	g_assert_false(parse_date("2023-01-01-01", &invalid));
+	g_assert_false(parse_date("1969", &invalid));
+}
+
+static void test_sorted_time_index(void)
+{
+	const gint64 times[] = { 10, 20, 20, 30 };
+
+	g_assert_cmpuint(sorted_time_index(times, 0, 10), ==, 0);
+	g_assert_cmpuint(sorted_time_index(times, 4, 5), ==, 0);
+	g_assert_cmpuint(sorted_time_index(times, 4, 10), ==, 0);
+	g_assert_cmpuint(sorted_time_index(times, 4, 15), ==, 1);
+	g_assert_cmpuint(sorted_time_index(times, 4, 20), ==, 1);
+	g_assert_cmpuint(sorted_time_index(times, 4, 21), ==, 3);
+	g_assert_cmpuint(sorted_time_index(times, 4, 30), ==, 3);
+	g_assert_cmpuint(sorted_time_index(times, 4, 31), ==, 4);
+}
+
+static void test_set_file_extension(void)
+{
+	const gchar *known[] = { "csv", "json", NULL };
+	const struct {
+		const gchar *name;
+		const gchar *extension;
+		const gchar *expected;
+	} names[] = {
+		{ "packages.csv", "csv", "packages.csv" },
+		{ "packages.csv", "json", "packages.json" },
+		{ "packages.CSV", "json", "packages.json" },
+		{ "packages.JSON", "json", "packages.JSON" },
+		{ "packages", "json", "packages.json" },
+		{ "packages.2023.csv", "json", "packages.2023.json" },
+		{ "packages.txt", "csv", "packages.txt.csv" },
+		{ ".csv", "json", ".csv.json" }
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(names); i++) {
+		gchar *result = set_file_extension(names[i].name, known, names[i].extension);
+
+		g_assert_cmpstr(result, ==, names[i].expected);
+		g_free(result);
+	}
+}
+
 void test_util(void)
 {
 	g_test_add_func("/util/list_to_string", test_list_to_string);
 	g_test_add_func("/util/human_readable_size", test_human_readable_size);
 	g_test_add_func("/util/strtrunc_dep_desc", test_strtrunc_dep_desc);
+	g_test_add_func("/util/parse_date", test_parse_date);
+	g_test_add_func("/util/sorted_time_index", test_sorted_time_index);
+	g_test_add_func("/util/set_file_extension", test_set_file_extension);
 }